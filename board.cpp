@@ -0,0 +1,280 @@
+/* Tetris project: board.cpp
+ *
+ * Board file, contains the rules of the game
+ *
+ * Program author/editor:
+ * Name: Rasmus Kivinen
+ * Student number: 285870
+ * UserID: kivinenr
+ * E-Mail: rasmus.kivinen@tuni.fi
+ * */
+
+#include "board.hh"
+
+namespace
+{
+// Squares of each tetromino when it is created, in the same order as the
+// main window has always created them (flip_shape depends on the order)
+const Board::Block SPAWN_SHAPES[Board::NUMBER_OF_TETROMINOS]
+                               [Board::BLOCKS_PER_TETROMINO] =
+{
+    {{4, 0}, {5, 0}, {6, 0}, {7, 0}},
+    {{5, 0}, {5, 1}, {6, 1}, {7, 1}},
+    {{7, 0}, {5, 1}, {6, 1}, {7, 1}},
+    {{5, 0}, {5, 1}, {6, 0}, {6, 1}},
+    {{6, 0}, {7, 0}, {6, 1}, {5, 1}},
+    {{6, 0}, {5, 1}, {6, 1}, {7, 1}},
+    {{6, 0}, {5, 0}, {6, 1}, {7, 1}}
+};
+
+Board::Block new_location(Board::Block block, Board::Direction dir)
+{
+    if(dir == Board::DOWN)
+    {
+        block.y += 1;
+    }
+
+    if(dir == Board::LEFT)
+    {
+        block.x -= 1;
+    }
+
+    if(dir == Board::RIGHT)
+    {
+        block.x += 1;
+    }
+
+    return block;
+}
+}
+
+const char Board::TETROMINO_LETTERS[] = "IJLOSTZ";
+
+Board::Board()
+{
+    //Every cell can hold at most one tetromino that does not overlap
+    //others, reserving that much keeps copies of the board from allocating
+    tetrominos_.reserve(COLUMNS * ROWS);
+    clear();
+}
+
+void Board::clear()
+{
+    tetrominos_.clear();
+    cells_.fill(0);
+    score_ = 0;
+}
+
+void Board::load(const std::vector<Tetromino>& shapes)
+{
+    clear();
+    for(const auto& shape: shapes)
+    {
+        tetrominos_.push_back(shape);
+        add_blocks(shape, 1);
+    }
+    score_ = tetrominos_.size() * BLOCKS_PER_TETROMINO;
+}
+
+bool Board::spawn_blocked() const
+{
+    return not block_can_move(MIDDLE_COLUMN, 0) ||
+           not block_can_move(MIDDLE_COLUMN, 1);
+}
+
+bool Board::create_tetromino(int kind)
+{
+    //If the spawning area for the new block is occupied, the game ends
+    if(spawn_blocked())
+    {
+        return false;
+    }
+
+    Tetromino shape;
+    shape.kind = kind;
+    for(int i = 0; i < BLOCKS_PER_TETROMINO; i++)
+    {
+        shape.blocks.at(i) = SPAWN_SHAPES[kind][i];
+    }
+
+    tetrominos_.push_back(shape);
+    add_blocks(shape, 1);
+
+    score_ += BLOCKS_PER_TETROMINO;
+    return true;
+}
+
+bool Board::move_block(Direction dir)
+{
+    if(tetrominos_.empty() || not shape_can_move(tetrominos_.size() - 1, dir))
+    {
+        return false;
+    }
+
+    move_tetromino(tetrominos_.back(), dir);
+    return true;
+}
+
+bool Board::drop_all()
+{
+    if(tetrominos_.empty())
+    {
+        return true;
+    }
+
+    //If the latest tetromino can't move any further down, a new one
+    //has to be created after this drop
+    bool stopped = not shape_can_move(tetrominos_.size() - 1, DOWN);
+
+    for(std::size_t i = 0; i < tetrominos_.size(); i++)
+    {
+        if(shape_can_move(i, DOWN))
+        {
+            move_tetromino(tetrominos_.at(i), DOWN);
+        }
+    }
+
+    return stopped;
+}
+
+void Board::drop_current()
+{
+    //Command the block to move down as many times as there are rows
+    //on the board
+    for(int i = 0; i <= ROWS; i++)
+    {
+        move_block(DOWN);
+    }
+}
+
+bool Board::flip_shape()
+{
+    if(tetrominos_.empty())
+    {
+        return false;
+    }
+
+    Tetromino& shape = tetrominos_.back();
+
+    //Define higher_y as the lowest point on the board
+    int higher_y = ROWS;
+
+    //Find the highest point of the shape
+    for(auto block: shape.blocks)
+    {
+        if(block.y <= higher_y)
+        {
+            higher_y = block.y;
+            if(not block_can_move(block.x, block.y + 2))
+            {
+                return false;
+            }
+        }
+    }
+
+    add_blocks(shape, -1);
+    for(auto& block: shape.blocks)
+    {
+        //If the block is on the higher row, move it below the lower row
+        if(block.y == higher_y)
+        {
+            block.y += 2;
+        }
+
+        //Move the whole shape up to avoid it falling faster
+        //because of the flip
+        block.y -= 1;
+    }
+    add_blocks(shape, 1);
+
+    return true;
+}
+
+void Board::set_current(const Tetromino& shape)
+{
+    if(tetrominos_.empty())
+    {
+        return;
+    }
+
+    add_blocks(tetrominos_.back(), -1);
+    tetrominos_.back() = shape;
+    add_blocks(shape, 1);
+}
+
+bool Board::block_can_move(int x, int y) const
+{
+    if(x < 0 || x >= COLUMNS || y < 0 || y >= ROWS)
+    {
+        return false;
+    }
+
+    return cells_[y * COLUMNS + x] == 0;
+}
+
+bool Board::shape_can_move(std::size_t index, Direction dir) const
+{
+    const Tetromino& shape = tetrominos_.at(index);
+
+    for(auto block: shape.blocks)
+    {
+        Block point = new_location(block, dir);
+        if(not block_can_move(point.x, point.y))
+        {
+            //If there is a block taking up the space, check if
+            //the block belongs to the same tetromino
+            //(the block will naturally move in the same direction)
+            bool occupied_by_buddy = false;
+
+            for(auto testblock: shape.blocks)
+            {
+                if(testblock.x == point.x && testblock.y == point.y)
+                {
+                    occupied_by_buddy = true;
+                }
+            }
+            if(occupied_by_buddy == false)
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+int Board::occupied(int x, int y) const
+{
+    return cells_[y * COLUMNS + x];
+}
+
+const std::vector<Board::Tetromino>& Board::tetrominos() const
+{
+    return tetrominos_;
+}
+
+int Board::score() const
+{
+    return score_;
+}
+
+void Board::move_tetromino(Tetromino& shape, Direction dir)
+{
+    add_blocks(shape, -1);
+    for(auto& block: shape.blocks)
+    {
+        block = new_location(block, dir);
+    }
+    add_blocks(shape, 1);
+}
+
+void Board::add_blocks(const Tetromino& shape, int amount)
+{
+    //Only blocks inside the board are counted
+    for(auto block: shape.blocks)
+    {
+        if(block.x >= 0 && block.x < COLUMNS && block.y >= 0 && block.y < ROWS)
+        {
+            cells_[block.y * COLUMNS + block.x] += amount;
+        }
+    }
+}
@@ -0,0 +1,174 @@
+/* Tetris project: board.hh
+ *
+ * Header file for the board, contains the rules of the game without
+ * any graphics so that they can be used by both the main window and
+ * the tools that play the game without it.
+ *
+ * Program author/editor:
+ * Name: Rasmus Kivinen
+ * Student number: 285870
+ * UserID: kivinenr
+ * E-Mail: rasmus.kivinen@tuni.fi
+ * */
+
+#ifndef BOARD_HH
+#define BOARD_HH
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+class Board
+{
+public:
+    // Number of horizontal and vertical cells, the same as the
+    // scene of the main window divided by the size of a square
+    static const int COLUMNS = 12;
+    static const int ROWS = 24;
+
+    // Column in which new tetrominos appear (MIDDLE_X of the main window)
+    static const int MIDDLE_COLUMN = 6;
+
+    // Number of different tetrominos and the squares in each of them
+    static const int NUMBER_OF_TETROMINOS = 7;
+    static const int BLOCKS_PER_TETROMINO = 4;
+
+    // Letters of the tetrominos by their kind, e.g. 'I' is kind 0
+    static const char TETROMINO_LETTERS[NUMBER_OF_TETROMINOS + 1];
+
+    enum Direction {DOWN, LEFT, RIGHT};
+
+    // A single square of a tetromino, in cells (not in scene coordinates)
+    struct Block
+    {
+        std::int8_t x;
+        std::int8_t y;
+    };
+
+    struct Tetromino
+    {
+        std::array<Block, BLOCKS_PER_TETROMINO> blocks;
+        std::uint8_t kind;
+    };
+
+    Board();
+
+    /**
+     * @brief clear Removes all tetrominos and resets the score
+     */
+    void clear();
+
+    /**
+     * @brief load Replaces the tetrominos on the board, e.g. from a replay
+     * @param shapes tetrominos in the order they were created
+     */
+    void load(const std::vector<Tetromino>& shapes);
+
+    /**
+     * @brief spawn_blocked Checks if the spawning area (middle column, two
+     *        highest rows) is occupied, which means the game is over
+     * @return true if a new tetromino can't be created
+     */
+    bool spawn_blocked() const;
+
+    /**
+     * @brief create_tetromino Adds a tetromino of the given kind to the top
+     *        of the board and adds its squares to the score. The new
+     *        tetromino may overlap old ones outside the spawning area,
+     *        just like in the original game.
+     * @param kind 0 - NUMBER_OF_TETROMINOS-1
+     * @return false if the spawning area was occupied (game over)
+     */
+    bool create_tetromino(int kind);
+
+    /**
+     * @brief move_block Moves the active (latest) tetromino one cell in
+     *        the specified direction, if it can move
+     * @param dir direction to move in
+     * @return true if the tetromino moved
+     */
+    bool move_block(Direction dir);
+
+    /**
+     * @brief drop_all Tries to move all tetrominos down one cell, in the
+     *        order they were created. Each tetromino falls as a whole,
+     *        so blocks stick to their tetromino.
+     * @return true if the active tetromino couldn't move any further
+     *         before the drop, meaning a new one should be created
+     */
+    bool drop_all();
+
+    /**
+     * @brief drop_current drops the active tetromino as far down as it can go
+     */
+    void drop_current();
+
+    /**
+     * @brief flip_shape mirrors the active tetromino vertically. Only works
+     *        with tetrominos that are 2 blocks high.
+     * @return false if the cells below the shape were occupied
+     */
+    bool flip_shape();
+
+    /**
+     * @brief set_current Puts the active tetromino to another place,
+     *        without checking if it can be there. Used for trying the
+     *        places a tetromino can reach without copying the board.
+     * @param shape the blocks of the active tetromino in the new place
+     */
+    void set_current(const Tetromino& shape);
+
+    /**
+     * @brief block_can_move Checks if a block can move to the specified cell
+     *                       (cell is within game bounds and not occupied)
+     * @param x column
+     * @param y row
+     * @return bool of whether moving is possible or not
+     */
+    bool block_can_move(int x, int y) const;
+
+    /**
+     * @brief shape_can_move Checks if the whole tetromino can move in the
+     *        specified direction, its own blocks don't block it
+     * @param index of the tetromino
+     * @param dir direction to check
+     * @return bool of whether the shape can move or not
+     */
+    bool shape_can_move(std::size_t index, Direction dir) const;
+
+    /**
+     * @brief occupied Tells how many blocks are in a cell, overlapping
+     *        tetrominos can put more than one block in the same cell
+     * @param x column
+     * @param y row
+     * @return number of blocks in the cell
+     */
+    int occupied(int x, int y) const;
+
+    const std::vector<Tetromino>& tetrominos() const;
+
+    /**
+     * @brief score Number of squares created this game
+     * @return the score
+     */
+    int score() const;
+
+private:
+    /**
+     * @brief move_tetromino Moves the tetromino one cell without checking
+     *        if it can move
+     */
+    void move_tetromino(Tetromino& shape, Direction dir);
+
+    void add_blocks(const Tetromino& shape, int amount);
+
+    // All the tetrominos on the board, the last one is the active one
+    std::vector<Tetromino> tetrominos_;
+
+    // Number of blocks in each cell, row by row
+    std::array<std::uint8_t, COLUMNS * ROWS> cells_;
+
+    int score_ = 0;
+};
+
+#endif // BOARD_HH
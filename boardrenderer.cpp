@@ -0,0 +1,72 @@
+/* Tetris project: boardrenderer.cpp
+ *
+ * Board renderer file, draws boards to images
+ *
+ * Program author/editor:
+ * Name: Rasmus Kivinen
+ * Student number: 285870
+ * UserID: kivinenr
+ * E-Mail: rasmus.kivinen@tuni.fi
+ * */
+
+#include "boardrenderer.hh"
+#include <QLinearGradient>
+#include <QPainter>
+#include <cstring>
+
+std::vector<QColor> BoardRenderer::colors()
+{
+    return {QColor("cyan"), QColor("magenta"), QColor("red"),
+            QColor("yellow"), QColor("darkCyan"), QColor("darkMagenta"),
+            QColor("green"), QColor("darkGreen"), QColor("red"),
+            QColor("blue")};
+}
+
+QBrush BoardRenderer::background_brush()
+{
+    // Setting the background's color and pattern
+    QLinearGradient gradient(WIDTH / 2, 0, HEIGHT, WIDTH / 2);
+    gradient.setColorAt(0, Qt::white);
+    gradient.setColorAt(1, Qt::black);
+    return QBrush(gradient);
+}
+
+BoardRenderer::BoardRenderer():
+    background_(create_image())
+{
+    QPainter painter(&background_);
+    painter.fillRect(background_.rect(), background_brush());
+
+    for(const auto& color: colors())
+    {
+        brushes_.push_back(QBrush(color, Qt::SolidPattern));
+    }
+}
+
+QImage BoardRenderer::create_image()
+{
+    return QImage(WIDTH, HEIGHT, QImage::Format_RGB32);
+}
+
+void BoardRenderer::render(const Board& board, QImage& image) const
+{
+    //Copying the bytes keeps the image from sharing (and later detaching)
+    //the background between threads
+    std::memcpy(image.bits(), background_.constBits(),
+                background_.bytesPerLine() * background_.height());
+
+    //Squares are drawn like QGraphicsRectItems with the default pen,
+    //without antialiasing like in the graphics view
+    QPainter painter(&image);
+    painter.setPen(QPen(Qt::black));
+
+    for(const auto& shape: board.tetrominos())
+    {
+        painter.setBrush(brushes_.at(shape.kind));
+        for(auto block: shape.blocks)
+        {
+            painter.drawRect(QRectF(block.x * SQUARE_SIDE, block.y * SQUARE_SIDE,
+                                    SQUARE_SIDE, SQUARE_SIDE));
+        }
+    }
+}
@@ -0,0 +1,63 @@
+/* Tetris project: boardrenderer.hh
+ *
+ * Header file for the board renderer, draws a board to an image the way
+ * the scene of the main window looks: the gradient background and the
+ * squares with their colors and black outlines. Works without a window,
+ * and one renderer can be used from many threads at the same time.
+ *
+ * Program author/editor:
+ * Name: Rasmus Kivinen
+ * Student number: 285870
+ * UserID: kivinenr
+ * E-Mail: rasmus.kivinen@tuni.fi
+ * */
+
+#ifndef BOARDRENDERER_HH
+#define BOARDRENDERER_HH
+
+#include "board.hh"
+#include <QBrush>
+#include <QColor>
+#include <QImage>
+#include <vector>
+
+class BoardRenderer
+{
+public:
+    // Size of a tetromino component and the whole board in pixels
+    static const int SQUARE_SIDE = 20;
+    static const int WIDTH = Board::COLUMNS * SQUARE_SIDE;
+    static const int HEIGHT = Board::ROWS * SQUARE_SIDE;
+
+    /**
+     * @brief colors Colors of the tetrominos, indexed by their kind
+     */
+    static std::vector<QColor> colors();
+
+    /**
+     * @brief background_brush The gradient behind the tetrominos
+     */
+    static QBrush background_brush();
+
+    BoardRenderer();
+
+    /**
+     * @brief create_image Creates an image of the right size and format
+     */
+    static QImage create_image();
+
+    /**
+     * @brief render Draws the board, the image must be from create_image
+     *        so that drawing doesn't need to allocate
+     * @param board to draw
+     * @param image to draw to
+     */
+    void render(const Board& board, QImage& image) const;
+
+private:
+    // The background is the same in every frame, so it is drawn only once
+    QImage background_;
+    std::vector<QBrush> brushes_;
+};
+
+#endif // BOARDRENDERER_HH
@@ -0,0 +1,174 @@
+/* Tetris project: bot.cpp
+ *
+ * Bot file, chooses placements for the tetrominos
+ *
+ * Program author/editor:
+ * Name: Rasmus Kivinen
+ * Student number: 285870
+ * UserID: kivinenr
+ * E-Mail: rasmus.kivinen@tuni.fi
+ * */
+
+#include "bot.hh"
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
+
+Bot::Bot(const Weights& weights):
+    weights_(weights)
+{
+}
+
+Bot::Weights Bot::features(const Board& board)
+{
+    Weights values = {};
+    int previous_height = -1;
+
+    for(int x = 0; x < Board::COLUMNS; x++)
+    {
+        //Height of the column is measured from its highest block,
+        //every empty cell below that is a hole
+        int height = 0;
+        for(int y = 0; y < Board::ROWS; y++)
+        {
+            if(board.occupied(x, y) > 0)
+            {
+                if(height == 0)
+                {
+                    height = Board::ROWS - y;
+                }
+            }
+            else if(height > 0)
+            {
+                values[HOLES] += 1;
+            }
+        }
+
+        values[AGGREGATE_HEIGHT] += height;
+        if(height > values[MAX_HEIGHT])
+        {
+            values[MAX_HEIGHT] = height;
+        }
+        if(x == Board::MIDDLE_COLUMN)
+        {
+            values[MIDDLE_HEIGHT] = height;
+        }
+        if(previous_height >= 0)
+        {
+            values[BUMPINESS] += std::abs(height - previous_height);
+        }
+        previous_height = height;
+    }
+
+    return values;
+}
+
+double Bot::evaluate(const Board& board) const
+{
+    Weights values = features(board);
+
+    double value = 0;
+    for(int i = 0; i < NUMBER_OF_FEATURES; i++)
+    {
+        value += weights_[i] * values[i];
+    }
+    return value;
+}
+
+bool Bot::apply_placement(Board& board, const Placement& placement)
+{
+    if(placement.flip && not board.flip_shape())
+    {
+        return false;
+    }
+
+    Board::Direction dir = placement.shift < 0 ? Board::LEFT : Board::RIGHT;
+    for(int i = 0; i < std::abs(placement.shift); i++)
+    {
+        if(not board.move_block(dir))
+        {
+            return false;
+        }
+    }
+
+    board.drop_current();
+    board.drop_all();
+    return true;
+}
+
+Bot::Placement Bot::best_placement(const Board& board)
+{
+    Placement best;
+    double best_value = -std::numeric_limits<double>::infinity();
+
+    for(int flip = 0; flip <= 1; flip++)
+    {
+        for(int shift = -Board::COLUMNS; shift <= Board::COLUMNS; shift++)
+        {
+            Placement placement;
+            placement.flip = flip == 1;
+            placement.shift = shift;
+
+            scratch_ = board;
+            if(not apply_placement(scratch_, placement))
+            {
+                continue;
+            }
+
+            double value = evaluate(scratch_);
+            if(value > best_value)
+            {
+                best_value = value;
+                best = placement;
+            }
+        }
+    }
+
+    return best;
+}
+
+int Bot::play_game(std::uint64_t seed, int max_pieces, PieceGenerator::Mode mode,
+                   GameLog::Record* record)
+{
+    //The same seed gives the same sequence as in the game itself
+    PieceGenerator pieces(seed, mode);
+
+    if(record != nullptr)
+    {
+        record->clear();
+        record->seed = seed;
+        record->piece_mode = mode == PieceGenerator::BAG ? "bag" : "uniform";
+    }
+
+    game_.clear();
+    for(int piece = 0; piece < max_pieces; piece++)
+    {
+        int kind = pieces.next();
+        if(not game_.create_tetromino(kind))
+        {
+            break;
+        }
+
+        Placement placement = best_placement(game_);
+        apply_placement(game_, placement);
+
+        if(record != nullptr)
+        {
+            int column = Board::COLUMNS;
+            for(auto block: game_.tetrominos().back().blocks)
+            {
+                column = std::min<int>(column, block.x);
+            }
+            record->pieces.push_back(kind);
+            record->placements.push_back(column);
+            record->flips += placement.flip ? 1 : 0;
+            record->drops += 1;
+        }
+    }
+
+    if(record != nullptr)
+    {
+        record->score = game_.score();
+    }
+    return game_.score();
+}
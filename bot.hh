@@ -0,0 +1,98 @@
+/* Tetris project: bot.hh
+ *
+ * Header file for the bot, plays the game by choosing where each
+ * tetromino is placed based on weighted features of the board
+ *
+ * Program author/editor:
+ * Name: Rasmus Kivinen
+ * Student number: 285870
+ * UserID: kivinenr
+ * E-Mail: rasmus.kivinen@tuni.fi
+ * */
+
+#ifndef BOT_HH
+#define BOT_HH
+
+#include "board.hh"
+#include "gamelog.hh"
+#include "piecegenerator.hh"
+#include <array>
+#include <cstdint>
+
+class Bot
+{
+public:
+    // Features of the board that the placements are evaluated with
+    enum Feature {AGGREGATE_HEIGHT,
+                  HOLES,
+                  BUMPINESS,
+                  MAX_HEIGHT,
+                  MIDDLE_HEIGHT,
+                  NUMBER_OF_FEATURES};
+
+    using Weights = std::array<double, NUMBER_OF_FEATURES>;
+
+    // Where the active tetromino is placed: whether it is flipped first
+    // and how many columns it is moved (negative is left) before dropping
+    struct Placement
+    {
+        bool flip = false;
+        int shift = 0;
+    };
+
+    explicit Bot(const Weights& weights);
+
+    /**
+     * @brief features Calculates the features of the board
+     * @param board to inspect
+     * @return value of each feature
+     */
+    static Weights features(const Board& board);
+
+    /**
+     * @brief evaluate Weighted sum of the features, higher is better
+     * @param board to evaluate
+     * @return the value of the board
+     */
+    double evaluate(const Board& board) const;
+
+    /**
+     * @brief apply_placement Places the active tetromino the way a player
+     *        would: flips it, moves it sideways, drops it and lets the
+     *        gravity tick once so that it stops
+     * @param board to place the tetromino on
+     * @param placement to apply
+     * @return false if the flip or one of the moves was not possible
+     */
+    static bool apply_placement(Board& board, const Placement& placement);
+
+    /**
+     * @brief best_placement Tries every placement of the active tetromino
+     * @param board with the active tetromino at the top
+     * @return the placement with the best value
+     */
+    Placement best_placement(const Board& board);
+
+    /**
+     * @brief play_game Plays a whole game with a fixed seed
+     * @param seed for the tetromino sequence
+     * @param max_pieces the game is stopped after this many tetrominos
+     * @param mode of the tetromino sequence
+     * @param record is filled with the statistics of the game if not null,
+     *        except for the source, difficulty and times
+     * @return the score of the game
+     */
+    int play_game(std::uint64_t seed, int max_pieces,
+                  PieceGenerator::Mode mode = PieceGenerator::UNIFORM,
+                  GameLog::Record* record = nullptr);
+
+private:
+    Weights weights_;
+
+    // Boards are reused between placements and games so that playing
+    // doesn't allocate
+    Board game_;
+    Board scratch_;
+};
+
+#endif // BOT_HH
@@ -0,0 +1,31 @@
+#-------------------------------------------------
+#
+# Exports replays to PNG sequences and contact
+# sheets without a window
+#
+#-------------------------------------------------
+
+QT += core gui concurrent
+
+TARGET = tetrisexport
+TEMPLATE = app
+
+CONFIG += console c++14 thread
+CONFIG -= app_bundle
+
+INCLUDEPATH += ..
+
+SOURCES += \
+        main.cpp \
+        frameexporter.cpp \
+        ../board.cpp \
+        ../boardrenderer.cpp \
+        ../replay.cpp \
+        ../memorytracker.cpp
+
+HEADERS += \
+        frameexporter.hh \
+        ../board.hh \
+        ../boardrenderer.hh \
+        ../replay.hh \
+        ../memorytracker.hh
@@ -0,0 +1,255 @@
+/* Tetris project: exporter/frameexporter.cpp
+ *
+ * Frame exporter file, draws and encodes the frames of a replay
+ *
+ * Program author/editor:
+ * Name: Rasmus Kivinen
+ * Student number: 285870
+ * UserID: kivinenr
+ * E-Mail: rasmus.kivinen@tuni.fi
+ * */
+
+#include "frameexporter.hh"
+#include <QBuffer>
+#include <QByteArray>
+#include <QDir>
+#include <QFile>
+#include <QImage>
+#include <QMutexLocker>
+#include <QPainter>
+#include <QThreadPool>
+#include <QtConcurrent>
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+// Output images per task. Each task seeks once, so bigger chunks replay
+// less, but there must be enough of them to keep all the threads busy.
+const std::size_t CHUNK_SIZE = 256;
+
+// Space between the thumbnails of a contact sheet, in pixels
+const int SHEET_SPACING = 4;
+
+// A range of output images that one task draws in order
+struct Chunk
+{
+    std::size_t begin;
+    std::size_t end;
+};
+
+QString frame_filename(const QString& directory, std::size_t index)
+{
+    return QDir(directory).filePath(QString("frame_%1.png")
+                                    .arg(index, 6, 10, QChar('0')));
+}
+}
+
+FrameExporter::FrameExporter(const Settings& settings):
+    settings_(settings), failed_(false), written_(0), encoded_(0)
+{
+    QThreadPool::globalInstance()->setMaxThreadCount(std::max(settings_.threads, 1));
+}
+
+bool FrameExporter::open(const std::string& filename)
+{
+    if(not reader_.open(filename))
+    {
+        error_ = reader_.error();
+        return false;
+    }
+    return true;
+}
+
+const std::string& FrameExporter::error() const
+{
+    return error_;
+}
+
+bool FrameExporter::export_sequence(const QString& directory)
+{
+    std::vector<std::uint64_t> frames = output_frames();
+    failed_ = false;
+    written_ = 0;
+    encoded_ = 0;
+
+    std::vector<Chunk> chunks;
+    for(std::size_t begin = 0; begin < frames.size(); begin += CHUNK_SIZE)
+    {
+        chunks.push_back({begin, std::min(begin + CHUNK_SIZE, frames.size())});
+    }
+
+    QtConcurrent::blockingMap(chunks, [&](const Chunk& chunk)
+    {
+        Board board;
+        ReplayReader::Cursor cursor;
+        QImage image = BoardRenderer::create_image();
+        QByteArray png;
+
+        for(std::size_t i = chunk.begin; i < chunk.end && not failed_; i++)
+        {
+            //The first frame of the chunk is found with a seek and the rest
+            //are played forward from it
+            std::size_t previous_offset = cursor.offset;
+            bool ok = i == chunk.begin ? reader_.seek(frames[i], board, cursor) :
+                                         reader_.advance(frames[i], board, cursor);
+            if(not ok)
+            {
+                fail("The replay is damaged");
+                return;
+            }
+
+            //Most frames don't have any events, for them the previous
+            //image is written again without drawing or encoding it
+            if(i == chunk.begin || cursor.offset != previous_offset)
+            {
+                renderer_.render(board, image);
+                png.clear();
+                QBuffer buffer(&png);
+                buffer.open(QIODevice::WriteOnly);
+                image.save(&buffer, "PNG", settings_.quality);
+                encoded_ += 1;
+            }
+
+            QFile file(frame_filename(directory, i));
+            if(not file.open(QIODevice::WriteOnly) ||
+               file.write(png) != png.size())
+            {
+                fail("Couldn't write " + file.fileName().toStdString());
+                return;
+            }
+            written_ += 1;
+        }
+    });
+
+    return not failed_;
+}
+
+bool FrameExporter::export_sheet(const QString& filename)
+{
+    int count = std::max(settings_.thumbnails, 1);
+    int columns = std::max(std::min(settings_.columns, count), 1);
+    int rows = (count + columns - 1) / columns;
+    failed_ = false;
+    written_ = 0;
+    encoded_ = 0;
+
+    //The thumbnails are spread evenly from the first to the last frame
+    std::uint64_t first = settings_.first;
+    std::uint64_t last = std::min(settings_.last, reader_.frames() - 1);
+    if(first > last)
+    {
+        first = last;
+    }
+    std::vector<std::uint64_t> frames;
+    for(int i = 0; i < count; i++)
+    {
+        frames.push_back(count == 1 ? first :
+                         first + (last - first) * i / (count - 1));
+    }
+
+    int width = std::max(1, static_cast<int>(BoardRenderer::WIDTH * settings_.scale));
+    int height = std::max(1, static_cast<int>(BoardRenderer::HEIGHT * settings_.scale));
+
+    std::vector<int> indices;
+    for(int i = 0; i < count; i++)
+    {
+        indices.push_back(i);
+    }
+
+    std::vector<QImage> thumbnails(count);
+    QtConcurrent::blockingMap(indices, [&](int i)
+    {
+        Board board;
+        ReplayReader::Cursor cursor;
+        QImage image = BoardRenderer::create_image();
+        if(not reader_.seek(frames.at(i), board, cursor))
+        {
+            fail("The replay is damaged");
+            return;
+        }
+        renderer_.render(board, image);
+        encoded_ += 1;
+        thumbnails.at(i) = image.scaled(width, height, Qt::IgnoreAspectRatio,
+                                        Qt::SmoothTransformation);
+    });
+
+    if(failed_)
+    {
+        return false;
+    }
+
+    QImage sheet(columns * width + (columns + 1) * SHEET_SPACING,
+                 rows * height + (rows + 1) * SHEET_SPACING, QImage::Format_RGB32);
+    sheet.fill(Qt::black);
+    QPainter painter(&sheet);
+    for(int i = 0; i < count; i++)
+    {
+        int x = SHEET_SPACING + (i % columns) * (width + SHEET_SPACING);
+        int y = SHEET_SPACING + (i / columns) * (height + SHEET_SPACING);
+        painter.drawImage(x, y, thumbnails.at(i));
+    }
+    painter.end();
+
+    if(not sheet.save(filename, "PNG", settings_.quality))
+    {
+        error_ = "Couldn't write " + filename.toStdString();
+        return false;
+    }
+    written_ = 1;
+    return true;
+}
+
+std::uint64_t FrameExporter::written() const
+{
+    return written_;
+}
+
+std::uint64_t FrameExporter::encoded() const
+{
+    return encoded_;
+}
+
+std::vector<std::uint64_t> FrameExporter::output_frames() const
+{
+    std::vector<std::uint64_t> frames;
+    std::uint64_t last = std::min(settings_.last, reader_.frames() - 1);
+    if(settings_.first > last)
+    {
+        return frames;
+    }
+
+    if(settings_.fps <= 0)
+    {
+        for(std::uint64_t frame = settings_.first; frame <= last; frame++)
+        {
+            frames.push_back(frame);
+        }
+        return frames;
+    }
+
+    //Each output image shows the replay frame that was on the screen at
+    //its time, so the video runs at the real speed of the game
+    double frames_per_image = 1000.0 / (settings_.fps * std::max(reader_.frame_ms(), 1u));
+    for(std::uint64_t i = 0; ; i++)
+    {
+        std::uint64_t frame = settings_.first +
+                static_cast<std::uint64_t>(std::floor(i * frames_per_image));
+        if(frame > last)
+        {
+            break;
+        }
+        frames.push_back(frame);
+    }
+    return frames;
+}
+
+void FrameExporter::fail(const std::string& error)
+{
+    QMutexLocker locker(&error_mutex_);
+    if(not failed_)
+    {
+        error_ = error;
+        failed_ = true;
+    }
+}
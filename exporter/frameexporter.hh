@@ -0,0 +1,97 @@
+/* Tetris project: exporter/frameexporter.hh
+ *
+ * Header file for the frame exporter, turns a replay into a PNG image
+ * sequence or a contact sheet of thumbnails without a window. The frames
+ * are split into chunks that are drawn and encoded on a thread pool, each
+ * chunk seeks once and then plays the replay forward.
+ *
+ * Program author/editor:
+ * Name: Rasmus Kivinen
+ * Student number: 285870
+ * UserID: kivinenr
+ * E-Mail: rasmus.kivinen@tuni.fi
+ * */
+
+#ifndef FRAMEEXPORTER_HH
+#define FRAMEEXPORTER_HH
+
+#include "replay.hh"
+#include "boardrenderer.hh"
+#include <QMutex>
+#include <QString>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+class FrameExporter
+{
+public:
+    struct Settings
+    {
+        // Frames to export, the last frame is limited to the replay's length
+        std::uint64_t first = 0;
+        std::uint64_t last = UINT64_MAX;
+        // Frames per second of the output, 0 exports every replay frame
+        double fps = 0;
+        // PNG quality 0 - 100, lower is smaller but slower to encode
+        int quality = 80;
+        // Contact sheet: number of thumbnails, thumbnails per row and
+        // their size compared to the board
+        int thumbnails = 16;
+        int columns = 4;
+        double scale = 0.5;
+        int threads = 1;
+    };
+
+    explicit FrameExporter(const Settings& settings);
+
+    /**
+     * @brief open Opens the replay to export
+     * @return false if the replay couldn't be read, see error()
+     */
+    bool open(const std::string& filename);
+
+    const std::string& error() const;
+
+    /**
+     * @brief export_sequence Writes the frames as frame_000000.png,
+     *        frame_000001.png, ... to the directory
+     * @param directory that must exist
+     * @return false if reading the replay or writing an image failed
+     */
+    bool export_sequence(const QString& directory);
+
+    /**
+     * @brief export_sheet Writes thumbnails of evenly spaced frames
+     *        into a single image, row by row
+     * @param filename of the image
+     * @return false if reading the replay or writing the image failed
+     */
+    bool export_sheet(const QString& filename);
+
+    // Number of images written and how many of them had to be encoded,
+    // frames where the board didn't change reuse the previous image
+    std::uint64_t written() const;
+    std::uint64_t encoded() const;
+
+private:
+    /**
+     * @brief output_frames The replay frames to export, one per output image
+     */
+    std::vector<std::uint64_t> output_frames() const;
+
+    void fail(const std::string& error);
+
+    Settings settings_;
+    ReplayReader reader_;
+    BoardRenderer renderer_;
+    std::string error_;
+
+    // Shared by the worker threads
+    QMutex error_mutex_;
+    std::atomic<bool> failed_;
+    std::atomic<std::uint64_t> written_;
+    std::atomic<std::uint64_t> encoded_;
+};
+
+#endif // FRAMEEXPORTER_HH
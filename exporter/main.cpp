@@ -0,0 +1,133 @@
+/* Tetris project: exporter/main.cpp
+ *
+ * Main function of the frame exporter. Usage:
+ *   tetrisexport REPLAY (--frames DIRECTORY | --sheet FILE)
+ *                [--from FRAME] [--to FRAME] [--fps N] [--quality N]
+ *                [--thumbnails N] [--columns N] [--scale X] [--threads N]
+ *
+ * --frames writes every frame (or --fps frames per second) as a PNG
+ * sequence, --sheet writes a contact sheet of --thumbnails evenly spaced
+ * frames. No display is needed, Qt's offscreen platform is used unless
+ * another one is set in QT_QPA_PLATFORM.
+ *
+ * Program author/editor:
+ * Name: Rasmus Kivinen
+ * Student number: 285870
+ * UserID: kivinenr
+ * E-Mail: rasmus.kivinen@tuni.fi
+ * */
+
+#include "frameexporter.hh"
+#include <QGuiApplication>
+#include <QThread>
+#include <chrono>
+#include <iostream>
+#include <string>
+
+int main(int argc, char *argv[])
+{
+    if(qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+    {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QGuiApplication app(argc, argv);
+
+    FrameExporter::Settings settings;
+    settings.threads = QThread::idealThreadCount();
+    std::string replay;
+    QString frames_directory;
+    QString sheet_filename;
+
+    for(int i = 1; i < argc; i++)
+    {
+        std::string option = argv[i];
+        if(option.compare(0, 2, "--") != 0)
+        {
+            replay = option;
+            continue;
+        }
+        if(i + 1 >= argc)
+        {
+            std::cerr << "Missing value for " << option << std::endl;
+            return 1;
+        }
+        std::string value = argv[++i];
+
+        if(option == "--frames")
+        {
+            frames_directory = QString::fromStdString(value);
+        }
+        else if(option == "--sheet")
+        {
+            sheet_filename = QString::fromStdString(value);
+        }
+        else if(option == "--from")
+        {
+            settings.first = std::stoull(value);
+        }
+        else if(option == "--to")
+        {
+            settings.last = std::stoull(value);
+        }
+        else if(option == "--fps")
+        {
+            settings.fps = std::stod(value);
+        }
+        else if(option == "--quality")
+        {
+            settings.quality = std::stoi(value);
+        }
+        else if(option == "--thumbnails")
+        {
+            settings.thumbnails = std::stoi(value);
+        }
+        else if(option == "--columns")
+        {
+            settings.columns = std::stoi(value);
+        }
+        else if(option == "--scale")
+        {
+            settings.scale = std::stod(value);
+        }
+        else if(option == "--threads")
+        {
+            settings.threads = std::stoi(value);
+        }
+        else
+        {
+            std::cerr << "Unknown option " << option << std::endl;
+            return 1;
+        }
+    }
+
+    if(replay.empty() || frames_directory.isEmpty() == sheet_filename.isEmpty())
+    {
+        std::cerr << "Give a replay and either --frames or --sheet" << std::endl;
+        return 1;
+    }
+
+    FrameExporter exporter(settings);
+    if(not exporter.open(replay))
+    {
+        std::cerr << exporter.error() << std::endl;
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    bool ok = frames_directory.isEmpty() ? exporter.export_sheet(sheet_filename) :
+                                           exporter.export_sequence(frames_directory);
+    double seconds = std::chrono::duration<double>(
+                std::chrono::steady_clock::now() - start).count();
+    if(not ok)
+    {
+        std::cerr << exporter.error() << std::endl;
+        return 1;
+    }
+
+    std::cout << exporter.written() << " images (" << exporter.encoded()
+              << " drawn) in " << seconds << " s, "
+              << static_cast<int>(exporter.written() / std::max(seconds, 1e-9))
+              << " images/s" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,356 @@
+/* Tetris project: game.cpp
+ *
+ * Game file, runs the board with the timing of the game
+ *
+ * Program author/editor:
+ * Name: Rasmus Kivinen
+ * Student number: 285870
+ * UserID: kivinenr
+ * E-Mail: rasmus.kivinen@tuni.fi
+ * */
+
+#include "game.hh"
+#include <algorithm>
+#include <cstdlib>
+
+namespace
+{
+const std::int64_t NS_PER_MS = 1000000;
+}
+
+bool Game::start(const Settings& settings, std::int64_t now_ns)
+{
+    pieces_.reset(settings.seed, settings.piece_mode);
+
+    record_.clear();
+    record_.seed = settings.seed;
+    record_.piece_mode = settings.piece_mode == PieceGenerator::BAG ? "bag" : "uniform";
+
+    board_.clear();
+    for(auto& state: inputs_)
+    {
+        state = Input_state();
+    }
+    set_repeat(settings.das_ms, settings.arr_ms);
+
+    start_ns_ = now_ns;
+    now_ns_ = now_ns;
+    frame_ = 0;
+    game_over_ = false;
+    paused_ = false;
+    input_latency_total_ = 0;
+    input_latency_max_ = 0;
+    input_latency_count_ = 0;
+
+    //Every game is recorded, the first keyframe is the empty board
+    bool recording = false;
+    if(not settings.replay_filename.empty())
+    {
+        recording = replay_writer_.open(settings.replay_filename,
+                                        REPLAY_KEYFRAME_FRAMES, FRAME_MS);
+        replay_writer_.advance(frame_, board_);
+    }
+
+    gravity_interval_ms_ = 0;
+    create_random_tetromino();
+
+    gravity_interval_ms_ = settings.gravity_interval_ms;
+    restart_gravity();
+
+    return recording || settings.replay_filename.empty();
+}
+
+void Game::set_repeat(int das_ms, int arr_ms)
+{
+    das_ms_ = das_ms;
+    arr_ms_ = arr_ms;
+}
+
+void Game::handle_input(const Input_event& event)
+{
+    if(paused_)
+    {
+        return;
+    }
+
+    Input_state& state = inputs_[event.input];
+
+    //Quick taps are never lost, the presses that are still pending are
+    //applied on the next step even if the input was already released
+    if(event.pressed)
+    {
+        state.held = true;
+        state.pending_presses += 1;
+        state.pressed_at = event.time_ns;
+        state.next_repeat_at = event.time_ns + das_ms_ * NS_PER_MS;
+    }
+    else
+    {
+        state.held = false;
+    }
+}
+
+bool Game::step(std::int64_t now_ns)
+{
+    if(game_over_ || paused_)
+    {
+        return false;
+    }
+
+    now_ns_ = now_ns;
+
+    //Frames follow the clock even if a step is late, so the time in the
+    //replay is the real time. Events of this frame come after the
+    //keyframes that are due.
+    frame_ = (now_ns - start_ns_) / (FRAME_MS * NS_PER_MS);
+    replay_writer_.advance(frame_, board_);
+
+    bool changed = process_inputs();
+
+    if(now_ns >= next_gravity_ns_)
+    {
+        drop_all();
+        changed = true;
+    }
+
+    return changed;
+}
+
+bool Game::is_over() const
+{
+    return game_over_;
+}
+
+void Game::pause(std::int64_t now_ns)
+{
+    if(paused_ || game_over_)
+    {
+        return;
+    }
+
+    paused_ = true;
+    paused_at_ = now_ns;
+    for(auto& state: inputs_)
+    {
+        state.held = false;
+    }
+}
+
+void Game::resume(std::int64_t now_ns)
+{
+    if(not paused_)
+    {
+        return;
+    }
+
+    //Everything that is timed moves forward by the length of the pause
+    std::int64_t paused_ns = now_ns - paused_at_;
+    start_ns_ += paused_ns;
+    now_ns_ += paused_ns;
+    next_gravity_ns_ += paused_ns;
+    for(auto& state: inputs_)
+    {
+        state.pressed_at += paused_ns;
+        state.next_repeat_at += paused_ns;
+    }
+    paused_ = false;
+}
+
+bool Game::is_paused() const
+{
+    return paused_;
+}
+
+std::int64_t Game::next_event_ns() const
+{
+    if(game_over_ || paused_)
+    {
+        return NO_EVENT;
+    }
+
+    std::int64_t next = next_gravity_ns_;
+    for(int i = 0; i < NUMBER_OF_INPUTS; i++)
+    {
+        const Input_state& state = inputs_[i];
+        if(state.pending_presses > 0)
+        {
+            next = std::min(next, now_ns_);
+        }
+        else if(state.held && i <= INPUT_DOWN)
+        {
+            next = std::min(next, state.next_repeat_at);
+        }
+    }
+
+    //Things happen on the first frame after they are due, like when the
+    //game was stepped on every frame
+    return next_frame_ns(next);
+}
+
+std::int64_t Game::next_frame_ns(std::int64_t time_ns) const
+{
+    std::int64_t frame_ns = FRAME_MS * NS_PER_MS;
+    std::int64_t elapsed = std::max<std::int64_t>(time_ns - start_ns_, 0);
+    return start_ns_ + (elapsed + frame_ns - 1) / frame_ns * frame_ns;
+}
+
+const GameLog::Record& Game::record() const
+{
+    return record_;
+}
+
+void Game::write_snapshot(Snapshot& snapshot) const
+{
+    snapshot.board = board_;
+    snapshot.game_over = game_over_;
+    snapshot.frame = frame_;
+    for(int i = 0; i < PieceGenerator::PREVIEW_SIZE; i++)
+    {
+        snapshot.preview.at(i) = pieces_.preview(i);
+    }
+    snapshot.latency_average_ns = input_latency_count_ > 0 ?
+                input_latency_total_ / input_latency_count_ : 0;
+    snapshot.latency_max_ns = input_latency_max_;
+}
+
+bool Game::process_inputs()
+{
+    std::int64_t arr_ns = std::max(arr_ms_, 1) * NS_PER_MS;
+
+    //Count how many moves each input has due in this step
+    int presses[NUMBER_OF_INPUTS] = {};
+    int moves[NUMBER_OF_INPUTS] = {};
+    bool any = false;
+    for(int i = 0; i < NUMBER_OF_INPUTS; i++)
+    {
+        Input_state& state = inputs_[i];
+
+        if(state.pending_presses > 0)
+        {
+            presses[i] = state.pending_presses;
+            state.pending_presses = 0;
+
+            std::int64_t latency = now_ns_ - state.pressed_at;
+            input_latency_total_ += latency;
+            input_latency_max_ = std::max(input_latency_max_, latency);
+            input_latency_count_ += 1;
+            record_.latencies_us.push_back(latency / 1000);
+        }
+        moves[i] = presses[i];
+
+        //Only moving inputs repeat, flipping and dropping happen once per press
+        if(state.held && i <= INPUT_DOWN)
+        {
+            while(state.next_repeat_at <= now_ns_ && moves[i] <= Board::ROWS)
+            {
+                moves[i] += 1;
+                state.next_repeat_at += arr_ns;
+            }
+        }
+
+        any = any || moves[i] > 0;
+    }
+
+    if(not any)
+    {
+        return false;
+    }
+
+    //Left and right arriving in the same step cancel each other out
+    int horizontal = moves[INPUT_RIGHT] - moves[INPUT_LEFT];
+    for(int i = 0; i < std::abs(horizontal); i++)
+    {
+        apply_event(horizontal > 0 ? Replay::MOVE_RIGHT : Replay::MOVE_LEFT);
+    }
+
+    for(int i = 0; i < moves[INPUT_DOWN]; i++)
+    {
+        apply_event(Replay::MOVE_DOWN);
+    }
+
+    //Restart gravity so it wont tick immediately after pressing down.
+    //Auto repeated moves don't restart it, so the next block still appears
+    //while the key is held
+    if(presses[INPUT_DOWN] > 0)
+    {
+        restart_gravity();
+    }
+
+    for(int i = 0; i < moves[INPUT_FLIP]; i++)
+    {
+        apply_event(Replay::FLIP);
+        record_.flips += 1;
+    }
+
+    if(moves[INPUT_DROP] > 0)
+    {
+        apply_event(Replay::DROP);
+        record_.drops += 1;
+    }
+
+    return true;
+}
+
+void Game::drop_all()
+{
+    //The gravity ticks at even intervals like a timer would
+    next_gravity_ns_ += gravity_interval_ms_ * NS_PER_MS;
+    if(next_gravity_ns_ <= now_ns_)
+    {
+        restart_gravity();
+    }
+
+    //If the latest tetromino couldn't move any further down,
+    //create a new one
+    if(apply_event(Replay::GRAVITY))
+    {
+        //The column where the tetromino stopped goes to the statistics
+        const Board::Tetromino& stopped = board_.tetrominos().back();
+        int column = Board::COLUMNS;
+        for(auto block: stopped.blocks)
+        {
+            column = std::min<int>(column, block.x);
+        }
+        record_.placements.push_back(column);
+
+        create_random_tetromino();
+    }
+}
+
+void Game::create_random_tetromino()
+{
+    //If the spawning area for the new block is occupied, the game ends
+    if(board_.spawn_blocked())
+    {
+        game_over_ = true;
+        replay_writer_.close();
+        record_.score = board_.score();
+        record_.duration_ms = frame_ * FRAME_MS;
+        return;
+    }
+
+    //Get the next tetromino of the sequence
+    int tetromino_number = pieces_.next();
+    apply_event(Replay::SPAWN, tetromino_number);
+    record_.pieces.push_back(tetromino_number);
+
+    //Speeds up the falling rate of the blocks (up to specified point),
+    //changing the interval restarts the gravity like it does with QTimer
+    if(GameRules::speed_up(gravity_interval_ms_))
+    {
+        restart_gravity();
+    }
+}
+
+void Game::restart_gravity()
+{
+    next_gravity_ns_ = now_ns_ + gravity_interval_ms_ * NS_PER_MS;
+}
+
+bool Game::apply_event(Replay::Event event, int kind)
+{
+    //Everything that changes the board goes through here, so the replay
+    //has the changes exactly the way they were done
+    replay_writer_.record(event, kind);
+    return Replay::apply(board_, event, kind);
+}
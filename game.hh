@@ -0,0 +1,236 @@
+/* Tetris project: game.hh
+ *
+ * Header file for the game, runs the board with the timing of the game:
+ * the gravity, the inputs of the player with delayed auto shift and auto
+ * repeat, the speeding up and the recording of the replay. All the times
+ * are nanoseconds of std::chrono::steady_clock.
+ *
+ * Program author/editor:
+ * Name: Rasmus Kivinen
+ * Student number: 285870
+ * UserID: kivinenr
+ * E-Mail: rasmus.kivinen@tuni.fi
+ * */
+
+#ifndef GAME_HH
+#define GAME_HH
+
+#include "board.hh"
+#include "gamelog.hh"
+#include "gamerules.hh"
+#include "piecegenerator.hh"
+#include "replay.hh"
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <string>
+
+class Game
+{
+public:
+    // Constants for the inputs the player can give, either with the
+    // keyboard or the push buttons
+    enum Input {INPUT_LEFT,
+                INPUT_RIGHT,
+                INPUT_DOWN,
+                INPUT_FLIP,
+                INPUT_DROP,
+                NUMBER_OF_INPUTS};
+
+    // Length of a frame, all the inputs received during a frame are
+    // applied to the board at once
+    static const int FRAME_MS = GameRules::FRAME_MS;
+
+    // Frames between two full boards in a replay file (10 seconds)
+    static const int REPLAY_KEYFRAME_FRAMES = 2500;
+
+    // Returned by next_event_ns when the game only changes on an input
+    static const std::int64_t NO_EVENT = std::numeric_limits<std::int64_t>::max();
+
+    struct Settings
+    {
+        // Interval of the gravity in the beginning, in milliseconds
+        int gravity_interval_ms = 1000;
+        // Delayed auto shift (how long a key must be held before it starts
+        // repeating) and auto repeat rate (interval between the repeated
+        // moves), in milliseconds
+        int das_ms = GameRules::DAS_MS;
+        int arr_ms = GameRules::ARR_MS;
+        // The seed decides the tetromino sequence, the same seed and mode
+        // always give the same tetrominos
+        std::uint64_t seed = 0;
+        PieceGenerator::Mode piece_mode = PieceGenerator::UNIFORM;
+        // The game is not recorded if this is empty
+        std::string replay_filename;
+    };
+
+    struct Input_event
+    {
+        Input input;
+        bool pressed;
+        std::int64_t time_ns;
+    };
+
+    // Everything the window needs for drawing the game
+    struct Snapshot
+    {
+        Board board;
+        bool game_over = false;
+        std::uint64_t frame = 0;
+        // Kinds of the next tetrominos, the first one is created next
+        std::array<std::uint8_t, PieceGenerator::PREVIEW_SIZE> preview = {};
+        // Time from key press to the move being on the board
+        std::int64_t latency_average_ns = 0;
+        std::int64_t latency_max_ns = 0;
+    };
+
+    /**
+     * @brief start Clears the board and creates the first tetromino
+     * @param settings of the game
+     * @param now_ns current time
+     * @return false if the replay file couldn't be created, the game
+     *         is started anyway
+     */
+    bool start(const Settings& settings, std::int64_t now_ns);
+
+    /**
+     * @brief set_repeat Changes the delayed auto shift and auto repeat rate
+     */
+    void set_repeat(int das_ms, int arr_ms);
+
+    /**
+     * @brief handle_input Marks the input held or released. A press always
+     *        moves once on the next step, holding the input starts repeating
+     *        after the delayed auto shift.
+     * @param event from the player
+     */
+    void handle_input(const Input_event& event);
+
+    /**
+     * @brief step Applies all presses and auto repeats that are due as one
+     *        batch and lets the gravity drop the tetrominos if it is time
+     * @param now_ns current time
+     * @return true if the board changed
+     */
+    bool step(std::int64_t now_ns);
+
+    bool is_over() const;
+
+    /**
+     * @brief pause Stops the clock of the game. Held inputs are released,
+     *        because their releases may never arrive while paused.
+     * @param now_ns current time
+     */
+    void pause(std::int64_t now_ns);
+
+    /**
+     * @brief resume Continues the game where it was paused, the gravity
+     *        and the frames continue as if no time had passed
+     * @param now_ns current time
+     */
+    void resume(std::int64_t now_ns);
+
+    bool is_paused() const;
+
+    /**
+     * @brief next_event_ns Time of the frame when the game has something
+     *        to do next without new inputs (gravity or an auto repeat)
+     * @return the time, or NO_EVENT if the game is over or paused
+     */
+    std::int64_t next_event_ns() const;
+
+    /**
+     * @brief next_frame_ns Start of the first frame at or after the time
+     */
+    std::int64_t next_frame_ns(std::int64_t time_ns) const;
+
+    /**
+     * @brief write_snapshot Copies the state of the game to the snapshot.
+     *        The board of the snapshot keeps its memory, so copying
+     *        doesn't allocate.
+     * @param snapshot to write to
+     */
+    void write_snapshot(Snapshot& snapshot) const;
+
+    /**
+     * @brief record Statistics of the game for the game log: the seed, the
+     *        tetrominos and where they stopped, the flips, drops and input
+     *        latencies, and the score and duration once the game is over
+     */
+    const GameLog::Record& record() const;
+
+private:
+    struct Input_state
+    {
+        bool held = false;
+        // Presses that have not yet been applied to the board
+        int pending_presses = 0;
+        std::int64_t pressed_at = 0;
+        std::int64_t next_repeat_at = 0;
+    };
+
+    /**
+     * @brief process_inputs Applies the presses and auto repeats that are due
+     * @return true if something was applied
+     */
+    bool process_inputs();
+
+    /**
+     * @brief drop_all Tries to move all shapes down one cell and creates
+     *        a new tetromino when the latest one has stopped
+     */
+    void drop_all();
+
+    /**
+     * @brief create_random_tetromino Creates a tetromino whose shape is
+     *        based on a random value, or ends the game if the spawning
+     *        area is occupied
+     */
+    void create_random_tetromino();
+
+    /**
+     * @brief restart_gravity The next gravity tick is a full interval from now
+     */
+    void restart_gravity();
+
+    /**
+     * @brief apply_event Changes the board and records the change to the
+     *        replay of the game
+     * @param event to apply
+     * @param kind of the new tetromino for SPAWN
+     * @return what the board function returned
+     */
+    bool apply_event(Replay::Event event, int kind = 0);
+
+    Board board_;
+    ReplayWriter replay_writer_;
+
+    // For randomly selecting the next dropping tetromino
+    PieceGenerator pieces_;
+
+    GameLog::Record record_;
+
+    Input_state inputs_[NUMBER_OF_INPUTS];
+    int das_ms_ = GameRules::DAS_MS;
+    int arr_ms_ = GameRules::ARR_MS;
+
+    std::int64_t start_ns_ = 0;
+    std::int64_t now_ns_ = 0;
+    std::uint64_t frame_ = 0;
+
+    // Gravity isn't running before the first tetromino is created,
+    // so the first one doesn't speed it up
+    int gravity_interval_ms_ = 0;
+    std::int64_t next_gravity_ns_ = 0;
+
+    bool game_over_ = false;
+
+    bool paused_ = false;
+    std::int64_t paused_at_ = 0;
+
+    std::int64_t input_latency_total_ = 0;
+    std::int64_t input_latency_max_ = 0;
+    int input_latency_count_ = 0;
+};
+
+#endif // GAME_HH
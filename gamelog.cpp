@@ -0,0 +1,762 @@
+/* Tetris project: gamelog.cpp
+ *
+ * Game log file, writes and reads the statistics of played games
+ *
+ * Program author/editor:
+ * Name: Rasmus Kivinen
+ * Student number: 285870
+ * UserID: kivinenr
+ * E-Mail: rasmus.kivinen@tuni.fi
+ * */
+
+#include "gamelog.hh"
+#include "memorytracker.hh"
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+const char HEADER_MAGIC[8] = {'T', 'T', 'R', 'L', 'O', 'G', '0', '1'};
+const char BLOCK_MAGIC[4] = {'T', 'L', 'B', 'K'};
+const std::uint32_t VERSION = 1;
+const std::size_t HEADER_SIZE = 16;
+const std::size_t BLOCK_HEADER_SIZE = 13;
+const std::size_t COLUMN_HEADER_SIZE = 5;
+
+// Dictionary entries are numbered with a byte
+const std::size_t MAX_DICTIONARY_SIZE = 255;
+const std::size_t MAX_STRING_LENGTH = 255;
+
+const char* const COLUMN_NAMES[GameLog::NUMBER_OF_COLUMNS] =
+{"source", "piece_mode", "difficulty", "seed", "start_time_ms", "duration_ms",
+ "score", "flips", "drops", "pieces", "placements", "latencies_us"};
+
+void put_u8(std::string& out, std::uint8_t value)
+{
+    out.push_back(char(value));
+}
+
+void put_fixed(std::string& out, std::uint64_t value, int width)
+{
+    for(int i = 0; i < width; i++)
+    {
+        out.push_back(char((value >> (8 * i)) & 0xff));
+    }
+}
+
+/**
+ * @brief width_for Smallest of the byte widths 0, 1, 2, 4 and 8 that
+ *        can hold the value
+ */
+int width_for(std::uint64_t value)
+{
+    if(value == 0)
+    {
+        return 0;
+    }
+    int width = 1;
+    while(width < 8 && (value >> (8 * width)) != 0)
+    {
+        width *= 2;
+    }
+    return width;
+}
+
+/**
+ * @brief range Smallest value and the distance from it to the largest one.
+ *        All the arithmetic wraps around like unsigned numbers, so any
+ *        64-bit values (e.g. seeds) can be stored.
+ */
+void range(const std::int64_t* values, std::size_t count,
+           std::int64_t& base, std::uint64_t& distance)
+{
+    if(count == 0)
+    {
+        base = 0;
+        distance = 0;
+        return;
+    }
+    auto minmax = std::minmax_element(values, values + count);
+    base = *minmax.first;
+    distance = std::uint64_t(*minmax.second) - std::uint64_t(base);
+}
+
+void encode_integers(std::string& out, const std::vector<std::int64_t>& values)
+{
+    std::int64_t base;
+    std::uint64_t distance;
+    range(values.data(), values.size(), base, distance);
+    int width = width_for(distance);
+
+    //Increasing values like times and seeds take less space as
+    //differences to the previous value
+    std::vector<std::int64_t> deltas;
+    for(std::size_t i = 1; i < values.size(); i++)
+    {
+        deltas.push_back(std::uint64_t(values.at(i)) - std::uint64_t(values.at(i - 1)));
+    }
+    std::int64_t delta_base;
+    std::uint64_t delta_distance;
+    range(deltas.data(), deltas.size(), delta_base, delta_distance);
+    int delta_width = width_for(delta_distance);
+
+    if(values.size() > 1 && delta_width < width)
+    {
+        put_u8(out, GameLog::DELTA);
+        put_fixed(out, values.size(), 4);
+        put_fixed(out, values.front(), 8);
+        put_fixed(out, delta_base, 8);
+        put_u8(out, delta_width);
+        for(auto delta: deltas)
+        {
+            put_fixed(out, std::uint64_t(delta) - std::uint64_t(delta_base), delta_width);
+        }
+    }
+    else
+    {
+        put_u8(out, GameLog::FRAME_OF_REFERENCE);
+        put_fixed(out, values.size(), 4);
+        put_fixed(out, base, 8);
+        put_u8(out, width);
+        for(auto value: values)
+        {
+            put_fixed(out, std::uint64_t(value) - std::uint64_t(base), width);
+        }
+    }
+}
+
+void encode_strings(std::string& out, const std::vector<std::uint8_t>& codes,
+                    const std::vector<std::string>& dictionary)
+{
+    put_u8(out, GameLog::DICTIONARY);
+    put_fixed(out, codes.size(), 4);
+    put_u8(out, dictionary.size());
+    for(const auto& entry: dictionary)
+    {
+        put_u8(out, entry.size());
+        out += entry;
+    }
+    out.append(codes.begin(), codes.end());
+}
+
+// Reads the data of a column without going past its end
+class Input
+{
+public:
+    Input(const unsigned char* data, std::size_t size):
+        data_(data), end_(data + size)
+    {
+    }
+
+    bool has(std::size_t bytes) const
+    {
+        return std::size_t(end_ - data_) >= bytes;
+    }
+
+    std::uint64_t fixed(int width)
+    {
+        std::uint64_t value = 0;
+        for(int i = 0; i < width; i++)
+        {
+            value |= std::uint64_t(data_[i]) << (8 * i);
+        }
+        data_ += width;
+        return value;
+    }
+
+    const unsigned char* take(std::size_t bytes)
+    {
+        const unsigned char* start = data_;
+        data_ += bytes;
+        return start;
+    }
+
+private:
+    const unsigned char* data_;
+    const unsigned char* end_;
+};
+
+/**
+ * @brief unpack Adds the base to fixed-width values, the width is a
+ *        template parameter so the loop has no branches
+ */
+template <int Width>
+void unpack(const unsigned char* data, std::size_t count, std::uint64_t base,
+            std::int64_t* values)
+{
+    for(std::size_t i = 0; i < count; i++)
+    {
+        std::uint64_t value = 0;
+        for(int b = 0; b < Width; b++)
+        {
+            value |= std::uint64_t(data[i * Width + b]) << (8 * b);
+        }
+        values[i] = base + value;
+    }
+}
+
+bool unpack(const unsigned char* data, std::size_t count, int width,
+            std::uint64_t base, std::int64_t* values)
+{
+    switch(width)
+    {
+    case 0:
+        std::fill(values, values + count, std::int64_t(base));
+        return true;
+    case 1:
+        unpack<1>(data, count, base, values);
+        return true;
+    case 2:
+        unpack<2>(data, count, base, values);
+        return true;
+    case 4:
+        unpack<4>(data, count, base, values);
+        return true;
+    case 8:
+        unpack<8>(data, count, base, values);
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool decode_integers(Input& input, std::vector<std::int64_t>& values)
+{
+    if(not input.has(5))
+    {
+        return false;
+    }
+    int encoding = input.fixed(1);
+    std::size_t count = input.fixed(4);
+
+    if(encoding == GameLog::FRAME_OF_REFERENCE)
+    {
+        if(not input.has(9))
+        {
+            return false;
+        }
+        std::uint64_t base = input.fixed(8);
+        int width = input.fixed(1);
+        if(not input.has(count * width))
+        {
+            return false;
+        }
+        values.resize(count);
+        return unpack(input.take(count * width), count, width, base, values.data());
+    }
+
+    if(encoding == GameLog::DELTA && count > 0)
+    {
+        if(not input.has(17))
+        {
+            return false;
+        }
+        std::uint64_t first = input.fixed(8);
+        std::uint64_t base = input.fixed(8);
+        int width = input.fixed(1);
+        if(not input.has((count - 1) * width))
+        {
+            return false;
+        }
+
+        //The differences are unpacked in place and then summed up
+        values.resize(count);
+        values.front() = first;
+        if(not unpack(input.take((count - 1) * width), count - 1, width, base,
+                      values.data() + 1))
+        {
+            return false;
+        }
+        for(std::size_t i = 1; i < count; i++)
+        {
+            values[i] = std::uint64_t(values[i]) + std::uint64_t(values[i - 1]);
+        }
+        return true;
+    }
+
+    return false;
+}
+}
+
+void GameLog::Record::clear()
+{
+    source.clear();
+    piece_mode.clear();
+    difficulty = 0;
+    seed = 0;
+    start_time_ms = 0;
+    duration_ms = 0;
+    score = 0;
+    flips = 0;
+    drops = 0;
+    pieces.clear();
+    placements.clear();
+    latencies_us.clear();
+}
+
+std::string GameLog::column_name(Column column)
+{
+    return COLUMN_NAMES[column];
+}
+
+GameLog::Column GameLog::column_from_name(const std::string& name)
+{
+    for(int i = 0; i < NUMBER_OF_COLUMNS; i++)
+    {
+        if(name == COLUMN_NAMES[i])
+        {
+            return Column(i);
+        }
+    }
+    return NUMBER_OF_COLUMNS;
+}
+
+bool GameLog::is_string_column(Column column)
+{
+    return column == SOURCE || column == PIECE_MODE;
+}
+
+bool GameLog::is_list_column(Column column)
+{
+    return column == PIECES || column == PLACEMENTS || column == LATENCIES_US;
+}
+
+GameLogWriter::GameLogWriter()
+{
+}
+
+GameLogWriter::~GameLogWriter()
+{
+    close();
+}
+
+bool GameLogWriter::open(const std::string& filename)
+{
+    //The columns of the blocks are counted as persistence, also when
+    //the tuner appends from its worker threads
+    MemoryScope scope(MemoryTracker::PERSISTENCE);
+    close();
+
+    //A block left half written by a crash is cut off, so the new
+    //blocks are not hidden behind it
+    struct stat info;
+    if(stat(filename.c_str(), &info) == 0 && info.st_size > 0)
+    {
+        GameLogReader reader;
+        if(not reader.open(filename))
+        {
+            return false;
+        }
+        std::size_t valid_size = HEADER_SIZE;
+        for(std::size_t i = 0; i < reader.blocks(); i++)
+        {
+            valid_size = reader.block_end(i);
+        }
+        reader.close();
+
+        if(valid_size < std::size_t(info.st_size) &&
+           truncate(filename.c_str(), valid_size) != 0)
+        {
+            return false;
+        }
+        file_.open(filename, std::ios::binary | std::ios::app);
+        return file_.is_open();
+    }
+
+    file_.open(filename, std::ios::binary | std::ios::app);
+    if(not file_.is_open())
+    {
+        return false;
+    }
+
+    std::string header(HEADER_MAGIC, sizeof(HEADER_MAGIC));
+    put_fixed(header, VERSION, 4);
+    put_fixed(header, 0, 4);
+    file_.write(header.data(), header.size());
+    file_.flush();
+    return file_.good();
+}
+
+bool GameLogWriter::is_open() const
+{
+    return file_.is_open();
+}
+
+bool GameLogWriter::append(const GameLog::Record& record)
+{
+    MemoryScope scope(MemoryTracker::PERSISTENCE);
+    std::lock_guard<std::mutex> lock(mutex_);
+    if(not file_.is_open())
+    {
+        return false;
+    }
+
+    //A new string that doesn't fit in the dictionary starts a new block.
+    //Both strings are checked first, because writing the block empties
+    //both dictionaries.
+    std::string values[] = {record.source.substr(0, MAX_STRING_LENGTH),
+                            record.piece_mode.substr(0, MAX_STRING_LENGTH)};
+    bool full = false;
+    for(int column = 0; column < 2; column++)
+    {
+        const auto& dictionary = dictionaries_[column];
+        full = full || (dictionary.size() == MAX_DICTIONARY_SIZE &&
+                        std::find(dictionary.begin(), dictionary.end(),
+                                  values[column]) == dictionary.end());
+    }
+    if(full && not write_block())
+    {
+        return false;
+    }
+
+    std::uint8_t codes[2];
+    for(int column = 0; column < 2; column++)
+    {
+        auto& dictionary = dictionaries_[column];
+        auto entry = std::find(dictionary.begin(), dictionary.end(), values[column]);
+        if(entry == dictionary.end())
+        {
+            dictionary.push_back(values[column]);
+            entry = dictionary.end() - 1;
+        }
+        codes[column] = entry - dictionary.begin();
+    }
+    codes_[GameLog::SOURCE].push_back(codes[0]);
+    codes_[GameLog::PIECE_MODE].push_back(codes[1]);
+
+    integers_[GameLog::DIFFICULTY].push_back(record.difficulty);
+    integers_[GameLog::SEED].push_back(record.seed);
+    integers_[GameLog::START_TIME_MS].push_back(record.start_time_ms);
+    integers_[GameLog::DURATION_MS].push_back(record.duration_ms);
+    integers_[GameLog::SCORE].push_back(record.score);
+    integers_[GameLog::FLIPS].push_back(record.flips);
+    integers_[GameLog::DROPS].push_back(record.drops);
+
+    list_lengths_[GameLog::PIECES].push_back(record.pieces.size());
+    integers_[GameLog::PIECES].insert(integers_[GameLog::PIECES].end(),
+                                      record.pieces.begin(), record.pieces.end());
+    list_lengths_[GameLog::PLACEMENTS].push_back(record.placements.size());
+    integers_[GameLog::PLACEMENTS].insert(integers_[GameLog::PLACEMENTS].end(),
+                                          record.placements.begin(),
+                                          record.placements.end());
+    list_lengths_[GameLog::LATENCIES_US].push_back(record.latencies_us.size());
+    integers_[GameLog::LATENCIES_US].insert(integers_[GameLog::LATENCIES_US].end(),
+                                            record.latencies_us.begin(),
+                                            record.latencies_us.end());
+
+    rows_ += 1;
+    if(rows_ == BLOCK_ROWS)
+    {
+        return write_block();
+    }
+    return true;
+}
+
+bool GameLogWriter::flush()
+{
+    MemoryScope scope(MemoryTracker::PERSISTENCE);
+    std::lock_guard<std::mutex> lock(mutex_);
+    if(not file_.is_open())
+    {
+        return false;
+    }
+    return write_block();
+}
+
+bool GameLogWriter::close()
+{
+    MemoryScope scope(MemoryTracker::PERSISTENCE);
+    if(not is_open())
+    {
+        return true;
+    }
+
+    bool ok = flush();
+    file_.close();
+    return ok;
+}
+
+bool GameLogWriter::write_block()
+{
+    if(rows_ == 0)
+    {
+        return true;
+    }
+
+    std::string columns;
+    for(int i = 0; i < GameLog::NUMBER_OF_COLUMNS; i++)
+    {
+        GameLog::Column column = GameLog::Column(i);
+        std::string data;
+        if(GameLog::is_string_column(column))
+        {
+            encode_strings(data, codes_[column], dictionaries_[column]);
+        }
+        else
+        {
+            if(GameLog::is_list_column(column))
+            {
+                encode_integers(data, list_lengths_[column]);
+            }
+            encode_integers(data, integers_[column]);
+        }
+
+        put_u8(columns, column);
+        put_fixed(columns, data.size(), 4);
+        columns += data;
+    }
+
+    std::string header(BLOCK_MAGIC, sizeof(BLOCK_MAGIC));
+    put_fixed(header, rows_, 4);
+    put_fixed(header, columns.size(), 4);
+    put_u8(header, GameLog::NUMBER_OF_COLUMNS);
+
+    //The block is written with one call and flushed, so another program
+    //reading the log only ever sees whole blocks or a cut off last one
+    header += columns;
+    file_.write(header.data(), header.size());
+    file_.flush();
+
+    rows_ = 0;
+    for(int i = 0; i < GameLog::NUMBER_OF_COLUMNS; i++)
+    {
+        integers_[i].clear();
+        list_lengths_[i].clear();
+    }
+    for(int i = 0; i < 2; i++)
+    {
+        codes_[i].clear();
+        dictionaries_[i].clear();
+    }
+
+    return file_.good();
+}
+
+GameLogReader::GameLogReader()
+{
+}
+
+GameLogReader::~GameLogReader()
+{
+    close();
+}
+
+bool GameLogReader::open(const std::string& filename)
+{
+    MemoryScope scope(MemoryTracker::PERSISTENCE);
+    close();
+    error_.clear();
+
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if(fd < 0)
+    {
+        error_ = "Could not open " + filename;
+        return false;
+    }
+
+    struct stat info;
+    if(fstat(fd, &info) != 0 || std::size_t(info.st_size) < HEADER_SIZE)
+    {
+        ::close(fd);
+        error_ = filename + " is not a game log";
+        return false;
+    }
+
+    //Queries go through the file once from start to end
+    void* mapping = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if(mapping == MAP_FAILED)
+    {
+        error_ = "Could not map " + filename;
+        return false;
+    }
+    data_ = static_cast<const unsigned char*>(mapping);
+    size_ = info.st_size;
+    madvise(mapping, size_, MADV_SEQUENTIAL);
+
+    Input header(data_ + sizeof(HEADER_MAGIC), HEADER_SIZE - sizeof(HEADER_MAGIC));
+    if(std::memcmp(data_, HEADER_MAGIC, sizeof(HEADER_MAGIC)) != 0 ||
+       header.fixed(4) != VERSION)
+    {
+        close();
+        error_ = filename + " is not a game log of this version";
+        return false;
+    }
+
+    //Only the small headers of the blocks are read here, a block that
+    //was cut off ends the log
+    std::size_t offset = HEADER_SIZE;
+    while(offset + BLOCK_HEADER_SIZE <= size_)
+    {
+        Input input(data_ + offset, BLOCK_HEADER_SIZE);
+        if(std::memcmp(input.take(sizeof(BLOCK_MAGIC)), BLOCK_MAGIC,
+                       sizeof(BLOCK_MAGIC)) != 0)
+        {
+            break;
+        }
+        Block block = {};
+        block.rows = input.fixed(4);
+        std::size_t size = input.fixed(4);
+        int count = input.fixed(1);
+
+        std::size_t start = offset + BLOCK_HEADER_SIZE;
+        if(size > size_ - start)
+        {
+            break;
+        }
+        block.end = start + size;
+
+        Input columns(data_ + start, size);
+        for(int i = 0; i < count && columns.has(COLUMN_HEADER_SIZE); i++)
+        {
+            int column = columns.fixed(1);
+            std::size_t column_size = columns.fixed(4);
+            if(not columns.has(column_size))
+            {
+                break;
+            }
+            const unsigned char* column_data = columns.take(column_size);
+
+            //Columns unknown to this version are skipped
+            if(column < GameLog::NUMBER_OF_COLUMNS)
+            {
+                block.offsets[column] = column_data - data_;
+                block.sizes[column] = column_size;
+            }
+        }
+
+        blocks_.push_back(block);
+        offset = block.end;
+    }
+
+    if(offset != size_)
+    {
+        error_ = filename + " ends with a damaged block";
+    }
+    return true;
+}
+
+void GameLogReader::close()
+{
+    if(data_ != nullptr)
+    {
+        munmap(const_cast<unsigned char*>(data_), size_);
+    }
+    data_ = nullptr;
+    size_ = 0;
+    blocks_.clear();
+}
+
+const std::string& GameLogReader::error() const
+{
+    return error_;
+}
+
+std::size_t GameLogReader::blocks() const
+{
+    return blocks_.size();
+}
+
+std::uint32_t GameLogReader::rows(std::size_t block) const
+{
+    return blocks_.at(block).rows;
+}
+
+std::size_t GameLogReader::block_end(std::size_t block) const
+{
+    return blocks_.at(block).end;
+}
+
+bool GameLogReader::read_integers(std::size_t block, GameLog::Column column,
+                                  std::vector<std::int64_t>& values) const
+{
+    MemoryScope scope(MemoryTracker::PERSISTENCE);
+    const Block& info = blocks_.at(block);
+    if(GameLog::is_string_column(column) || GameLog::is_list_column(column) ||
+       info.sizes[column] == 0)
+    {
+        return false;
+    }
+
+    Input input(data_ + info.offsets[column], info.sizes[column]);
+    return decode_integers(input, values) && values.size() == info.rows;
+}
+
+bool GameLogReader::read_strings(std::size_t block, GameLog::Column column,
+                                 std::vector<std::uint8_t>& codes,
+                                 std::vector<std::string>& dictionary) const
+{
+    MemoryScope scope(MemoryTracker::PERSISTENCE);
+    const Block& info = blocks_.at(block);
+    if(not GameLog::is_string_column(column) || info.sizes[column] == 0)
+    {
+        return false;
+    }
+
+    Input input(data_ + info.offsets[column], info.sizes[column]);
+    if(not input.has(6) || input.fixed(1) != GameLog::DICTIONARY)
+    {
+        return false;
+    }
+    std::size_t count = input.fixed(4);
+    std::size_t entries = input.fixed(1);
+
+    dictionary.clear();
+    for(std::size_t i = 0; i < entries; i++)
+    {
+        if(not input.has(1))
+        {
+            return false;
+        }
+        std::size_t length = input.fixed(1);
+        if(not input.has(length))
+        {
+            return false;
+        }
+        const char* characters = reinterpret_cast<const char*>(input.take(length));
+        dictionary.push_back(std::string(characters, length));
+    }
+
+    if(count != info.rows || not input.has(count))
+    {
+        return false;
+    }
+    const unsigned char* data = input.take(count);
+    codes.assign(data, data + count);
+
+    return std::all_of(codes.begin(), codes.end(),
+                       [entries](std::uint8_t code) { return code < entries; });
+}
+
+bool GameLogReader::read_lists(std::size_t block, GameLog::Column column,
+                               std::vector<std::int64_t>& lengths,
+                               std::vector<std::int64_t>* items) const
+{
+    MemoryScope scope(MemoryTracker::PERSISTENCE);
+    const Block& info = blocks_.at(block);
+    if(not GameLog::is_list_column(column) || info.sizes[column] == 0)
+    {
+        return false;
+    }
+
+    Input input(data_ + info.offsets[column], info.sizes[column]);
+    if(not decode_integers(input, lengths) || lengths.size() != info.rows)
+    {
+        return false;
+    }
+    if(items == nullptr)
+    {
+        return true;
+    }
+
+    std::int64_t total = 0;
+    for(auto length: lengths)
+    {
+        total += length;
+    }
+    return decode_integers(input, *items) && std::int64_t(items->size()) == total;
+}
@@ -0,0 +1,235 @@
+/* Tetris project: gamelog.hh
+ *
+ * Header file for the game log, a columnar file of statistics about
+ * played games, one row per game. Games are collected into blocks that
+ * are appended to the end of the file, and inside a block each column is
+ * stored on its own so a query only reads the columns it needs.
+ *
+ * File layout (all numbers little-endian):
+ *   header   "TTRLOG01", u32 version, u32 reserved
+ *   blocks   "TLBK", u32 rows, u32 size of the columns, u8 columns,
+ *            and for each column u8 Column, u32 size, data
+ *
+ * The data of a column is one of
+ *   integers    u8 FRAME_OF_REFERENCE, u32 count, i64 base, u8 width,
+ *               and count values - base of the given byte width
+ *               u8 DELTA, u32 count, i64 first, i64 base, u8 width,
+ *               and count - 1 differences to the previous value - base
+ *   strings     u8 DICTIONARY, u32 count, u8 entries, u8 length and the
+ *               characters of each entry, and count u8 entry numbers
+ *   lists       integers of the list lengths followed by integers of all
+ *               the list items of the block
+ * The widths are 0, 1, 2, 4 or 8 bytes, so decoding is a simple loop
+ * over a fixed-width array that the compiler can vectorize.
+ *
+ * Program author/editor:
+ * Name: Rasmus Kivinen
+ * Student number: 285870
+ * UserID: kivinenr
+ * E-Mail: rasmus.kivinen@tuni.fi
+ * */
+
+#ifndef GAMELOG_HH
+#define GAMELOG_HH
+
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace GameLog
+{
+// Columns of the log in the order they are written. The first two are
+// strings, the last three lists and the rest integers.
+enum Column {SOURCE,
+             PIECE_MODE,
+             DIFFICULTY,
+             SEED,
+             START_TIME_MS,
+             DURATION_MS,
+             SCORE,
+             FLIPS,
+             DROPS,
+             PIECES,
+             PLACEMENTS,
+             LATENCIES_US,
+             NUMBER_OF_COLUMNS};
+
+enum Encoding {FRAME_OF_REFERENCE,
+               DELTA,
+               DICTIONARY};
+
+// Everything that is logged about a game
+struct Record
+{
+    // Who played the game, e.g. "player" or "bot"
+    std::string source;
+    // "uniform" or "bag"
+    std::string piece_mode;
+    // Difficulty level 1-4 of the main window, 0 for games without one
+    int difficulty = 0;
+    std::uint64_t seed = 0;
+    // Milliseconds since 1970 when the game started
+    std::int64_t start_time_ms = 0;
+    // Time played, pauses not included
+    std::int64_t duration_ms = 0;
+    int score = 0;
+    int flips = 0;
+    int drops = 0;
+    // Kind of each tetromino and the leftmost column it stopped in
+    std::vector<std::uint8_t> pieces;
+    std::vector<std::uint8_t> placements;
+    // Time from each key press to the move being on the board
+    std::vector<std::uint32_t> latencies_us;
+
+    /**
+     * @brief clear Empties the record, keeping the memory of the lists
+     */
+    void clear();
+};
+
+/**
+ * @brief column_name Name of the column, e.g. "difficulty"
+ */
+std::string column_name(Column column);
+
+/**
+ * @brief column_from_name Finds a column by its name
+ * @return the column, or NUMBER_OF_COLUMNS if there is no such column
+ */
+Column column_from_name(const std::string& name);
+
+bool is_string_column(Column column);
+bool is_list_column(Column column);
+}
+
+class GameLogWriter
+{
+public:
+    // Rows in a full block, smaller blocks are written by flush()
+    static const std::uint32_t BLOCK_ROWS = 65536;
+
+    GameLogWriter();
+    ~GameLogWriter();
+
+    /**
+     * @brief open Opens a log for appending, or creates it
+     * @param filename of the log
+     * @return false if the file couldn't be opened or isn't a game log
+     */
+    bool open(const std::string& filename);
+
+    bool is_open() const;
+
+    /**
+     * @brief append Adds a game to the current block, the block is written
+     *        when it is full. Can be called from many threads at once.
+     * @param record of the game
+     * @return false if writing a full block failed
+     */
+    bool append(const GameLog::Record& record);
+
+    /**
+     * @brief flush Writes the games of the current block, even if it
+     *        isn't full
+     * @return false if writing failed
+     */
+    bool flush();
+
+    /**
+     * @brief close Flushes and closes the file
+     * @return false if writing failed
+     */
+    bool close();
+
+private:
+    bool write_block();
+
+    std::mutex mutex_;
+    std::ofstream file_;
+
+    // Columns of the current block. The string columns are SOURCE and
+    // PIECE_MODE, the items of the lists are kept in integers_.
+    std::uint32_t rows_ = 0;
+    std::vector<std::uint8_t> codes_[2];
+    std::vector<std::string> dictionaries_[2];
+    std::vector<std::int64_t> integers_[GameLog::NUMBER_OF_COLUMNS];
+    std::vector<std::int64_t> list_lengths_[GameLog::NUMBER_OF_COLUMNS];
+};
+
+class GameLogReader
+{
+public:
+    GameLogReader();
+    ~GameLogReader();
+
+    /**
+     * @brief open Maps the log file to memory and finds its blocks. If the
+     *        last block was cut off, the blocks before it can be read and
+     *        error() tells about it.
+     * @param filename of the log
+     * @return false if the file couldn't be read, see error()
+     */
+    bool open(const std::string& filename);
+
+    void close();
+
+    const std::string& error() const;
+
+    std::size_t blocks() const;
+    std::uint32_t rows(std::size_t block) const;
+
+    /**
+     * @brief block_end Offset of the first byte after the block in the file
+     */
+    std::size_t block_end(std::size_t block) const;
+
+    /**
+     * @brief read_integers Decodes an integer column of a block
+     * @param block number
+     * @param column to read
+     * @param values are set to the values of the rows
+     * @return false if the block is damaged
+     */
+    bool read_integers(std::size_t block, GameLog::Column column,
+                       std::vector<std::int64_t>& values) const;
+
+    /**
+     * @brief read_strings Decodes a string column of a block
+     * @param codes are set to the dictionary entry of each row
+     * @param dictionary is set to the strings of the block
+     * @return false if the block is damaged
+     */
+    bool read_strings(std::size_t block, GameLog::Column column,
+                      std::vector<std::uint8_t>& codes,
+                      std::vector<std::string>& dictionary) const;
+
+    /**
+     * @brief read_lists Decodes a list column of a block
+     * @param lengths are set to the list length of each row
+     * @param items are set to the items of all the lists one after another,
+     *        or are not decoded if this is null
+     * @return false if the block is damaged
+     */
+    bool read_lists(std::size_t block, GameLog::Column column,
+                    std::vector<std::int64_t>& lengths,
+                    std::vector<std::int64_t>* items) const;
+
+private:
+    struct Block
+    {
+        std::uint32_t rows;
+        std::size_t end;
+        // Offset and size of each column, size 0 if it is missing
+        std::size_t offsets[GameLog::NUMBER_OF_COLUMNS];
+        std::size_t sizes[GameLog::NUMBER_OF_COLUMNS];
+    };
+
+    const unsigned char* data_ = nullptr;
+    std::size_t size_ = 0;
+    std::string error_;
+    std::vector<Block> blocks_;
+};
+
+#endif // GAMELOG_HH
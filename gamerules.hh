@@ -0,0 +1,64 @@
+/* Tetris project: gamerules.hh
+ *
+ * Rules of the timing that the single player game and the versus game
+ * share: the length of a frame, the default key repeat, the speeding up
+ * of the gravity and the clock. Works without Qt, so the tools that
+ * only run versus games don't need the rest of the single player game.
+ *
+ * Program author/editor:
+ * Name: Rasmus Kivinen
+ * Student number: 285870
+ * UserID: kivinenr
+ * E-Mail: rasmus.kivinen@tuni.fi
+ * */
+
+#ifndef GAMERULES_HH
+#define GAMERULES_HH
+
+#include <chrono>
+#include <cstdint>
+
+namespace GameRules
+{
+// Length of a frame of the single player game and a tick of the versus
+// game, all the inputs of a frame are applied to the board at once
+const int FRAME_MS = 4;
+
+// Delayed auto shift (how long a key must be held before it starts
+// repeating) and auto repeat rate (interval between the repeated moves)
+// when the player hasn't changed them, in milliseconds
+const int DAS_MS = 170;
+const int ARR_MS = 50;
+
+// Constants defining max speed of blocks and how fast it changes
+// as the game goes on
+const int MAXIMUM_SPEED = 100;
+const float SPEED_CHANGE_RATE = 0.95;
+
+/**
+ * @brief speed_up Shortens the gravity interval when a tetromino is
+ *        created, up to the maximum speed
+ * @param gravity_interval_ms to shorten
+ * @return true if the interval changed, the gravity is then restarted
+ */
+inline bool speed_up(int& gravity_interval_ms)
+{
+    if(gravity_interval_ms <= MAXIMUM_SPEED)
+    {
+        return false;
+    }
+    gravity_interval_ms = gravity_interval_ms * SPEED_CHANGE_RATE;
+    return true;
+}
+
+/**
+ * @brief now_ns Current time of the clock the games use
+ */
+inline std::int64_t now_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+}
+
+#endif // GAMERULES_HH
@@ -0,0 +1,201 @@
+/* Tetris project: gamethread.cpp
+ *
+ * Game thread file, runs the game on its own thread
+ *
+ * Program author/editor:
+ * Name: Rasmus Kivinen
+ * Student number: 285870
+ * UserID: kivinenr
+ * E-Mail: rasmus.kivinen@tuni.fi
+ * */
+
+#include "gamethread.hh"
+#include "gamerules.hh"
+#include "memorytracker.hh"
+#include <chrono>
+
+GameThread::GameThread()
+{
+}
+
+GameThread::~GameThread()
+{
+    stop();
+}
+
+bool GameThread::start(const Game::Settings& settings)
+{
+    stop();
+    MemoryScope scope(MemoryTracker::GAME_STATE);
+
+    das_ms_ = settings.das_ms;
+    arr_ms_ = settings.arr_ms;
+
+    //Inputs left from the previous game are forgotten
+    Game::Input_event event;
+    while(inputs_.pop(event))
+    {
+    }
+
+    //The game is started before the thread, so the first snapshot is
+    //there as soon as this returns
+    bool recording = game_.start(settings, GameRules::now_ns());
+    game_.write_snapshot(snapshots_.write_buffer());
+    snapshots_.publish();
+
+    paused_ = false;
+    wakeups_ = 0;
+    running_ = true;
+    thread_ = std::thread(&GameThread::run, this);
+    return recording;
+}
+
+void GameThread::stop()
+{
+    running_ = false;
+    wake();
+    if(thread_.joinable())
+    {
+        thread_.join();
+    }
+}
+
+void GameThread::push_input(Game::Input input, bool pressed)
+{
+    if(not running_)
+    {
+        return;
+    }
+
+    //If the game thread is that far behind, the input is dropped
+    //rather than making the window wait
+    Game::Input_event event = {input, pressed, GameRules::now_ns()};
+    inputs_.push(event);
+    wake();
+}
+
+void GameThread::set_publish_callback(const std::function<void()>& callback)
+{
+    //Only changed while the thread isn't running
+    stop();
+    publish_callback_ = callback;
+}
+
+void GameThread::set_paused(bool paused)
+{
+    paused_ = paused;
+    wake();
+}
+
+bool GameThread::is_running() const
+{
+    return running_;
+}
+
+std::uint64_t GameThread::wakeups() const
+{
+    return wakeups_;
+}
+
+void GameThread::set_repeat(int das_ms, int arr_ms)
+{
+    das_ms_ = das_ms;
+    arr_ms_ = arr_ms;
+}
+
+bool GameThread::update_snapshot()
+{
+    return snapshots_.update();
+}
+
+const Game::Snapshot& GameThread::snapshot() const
+{
+    return snapshots_.read_buffer();
+}
+
+const GameLog::Record& GameThread::record() const
+{
+    return game_.record();
+}
+
+void GameThread::run()
+{
+    MemoryScope scope(MemoryTracker::GAME_STATE);
+    while(running_)
+    {
+        wakeups_ += 1;
+        game_.set_repeat(das_ms_, arr_ms_);
+
+        std::int64_t now = GameRules::now_ns();
+        if(paused_ && not game_.is_paused())
+        {
+            game_.pause(now);
+        }
+        else if(not paused_ && game_.is_paused())
+        {
+            game_.resume(now);
+        }
+
+        Game::Input_event event;
+        while(inputs_.pop(event))
+        {
+            game_.handle_input(event);
+        }
+
+        //A snapshot is only published when the board has changed
+        if(game_.step(now))
+        {
+            game_.write_snapshot(snapshots_.write_buffer());
+            snapshots_.publish();
+            if(publish_callback_)
+            {
+                publish_callback_();
+            }
+        }
+
+        if(game_.is_over())
+        {
+            break;
+        }
+
+        //Nothing happens between the gravity ticks and auto repeats, so
+        //the thread sleeps until the next one instead of every frame. An
+        //input is applied at the start of the next frame together with
+        //the other inputs of the same frame.
+        if(sleep_until(game_.next_event_ns()) && not inputs_.empty())
+        {
+            std::this_thread::sleep_until(std::chrono::steady_clock::time_point(
+                        std::chrono::nanoseconds(
+                            game_.next_frame_ns(GameRules::now_ns()))));
+        }
+    }
+
+    running_ = false;
+}
+
+void GameThread::wake()
+{
+    //Locking the mutex makes sure the thread is either not yet checking
+    //whether to sleep or already sleeping, so the notification isn't lost
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+    }
+    wake_.notify_one();
+}
+
+bool GameThread::sleep_until(std::int64_t time_ns)
+{
+    auto woken = [this]()
+    {
+        return not running_ || not inputs_.empty() || paused_ != game_.is_paused();
+    };
+
+    std::unique_lock<std::mutex> lock(wake_mutex_);
+    if(time_ns == Game::NO_EVENT)
+    {
+        wake_.wait(lock, woken);
+        return true;
+    }
+    return wake_.wait_until(lock, std::chrono::steady_clock::time_point(
+                                std::chrono::nanoseconds(time_ns)), woken);
+}
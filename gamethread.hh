@@ -0,0 +1,128 @@
+/* Tetris project: gamethread.hh
+ *
+ * Header file for the game thread, runs the game on its own thread so
+ * that drawing the window and the game never wait for each other. The
+ * window pushes the inputs of the player to a lock-free queue and reads
+ * the latest snapshot of the game from a lock-free triple buffer.
+ * Between the frames where something happens the thread sleeps, so an
+ * idle or paused game doesn't use the CPU at all.
+ *
+ * Program author/editor:
+ * Name: Rasmus Kivinen
+ * Student number: 285870
+ * UserID: kivinenr
+ * E-Mail: rasmus.kivinen@tuni.fi
+ * */
+
+#ifndef GAMETHREAD_HH
+#define GAMETHREAD_HH
+
+#include "game.hh"
+#include "spscqueue.hh"
+#include "triplebuffer.hh"
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+class GameThread
+{
+public:
+    GameThread();
+    ~GameThread();
+
+    /**
+     * @brief start Starts a new game on the thread
+     * @param settings of the game
+     * @return false if the replay file couldn't be created
+     */
+    bool start(const Game::Settings& settings);
+
+    /**
+     * @brief stop Stops the thread, the last snapshot can still be read
+     */
+    void stop();
+
+    /**
+     * @brief set_publish_callback Sets a function that the game thread
+     *        calls every time it has published a new snapshot
+     */
+    void set_publish_callback(const std::function<void()>& callback);
+
+    /**
+     * @brief set_paused Pauses or resumes the game, e.g. when the window
+     *        is hidden. A paused game sleeps until it is resumed.
+     */
+    void set_paused(bool paused);
+
+    bool is_running() const;
+
+    /**
+     * @brief wakeups How many times the thread has woken up this game
+     */
+    std::uint64_t wakeups() const;
+
+    /**
+     * @brief push_input Passes an input of the player to the game, only
+     *        from the thread that started the game
+     * @param input that was pressed or released
+     * @param pressed true for a press, false for a release
+     */
+    void push_input(Game::Input input, bool pressed);
+
+    /**
+     * @brief set_repeat Changes the delayed auto shift and auto repeat rate
+     */
+    void set_repeat(int das_ms, int arr_ms);
+
+    /**
+     * @brief update_snapshot Takes the latest snapshot of the game, only
+     *        from the thread that started the game
+     * @return true if the game has changed since the last update
+     */
+    bool update_snapshot();
+
+    const Game::Snapshot& snapshot() const;
+
+    /**
+     * @brief record Statistics of the game, only while the thread isn't
+     *        running (e.g. after the game is over and stop() was called)
+     */
+    const GameLog::Record& record() const;
+
+private:
+    void run();
+
+    /**
+     * @brief wake Wakes the thread up if it is sleeping
+     */
+    void wake();
+
+    /**
+     * @brief sleep_until Sleeps until the time, an input, a pause change
+     *        or stopping
+     * @return true if the thread was woken up before the time
+     */
+    bool sleep_until(std::int64_t time_ns);
+
+    Game game_;
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+    std::atomic<bool> paused_{false};
+    std::atomic<std::uint64_t> wakeups_{0};
+
+    // The window only locks the mutex to wake the thread up, the inputs
+    // and snapshots themselves are still passed without locks
+    std::mutex wake_mutex_;
+    std::condition_variable wake_;
+    std::function<void()> publish_callback_;
+
+    std::atomic<int> das_ms_{0};
+    std::atomic<int> arr_ms_{0};
+
+    SpscQueue<Game::Input_event, 256> inputs_;
+    TripleBuffer<Game::Snapshot> snapshots_;
+};
+
+#endif // GAMETHREAD_HH
@@ -0,0 +1,255 @@
+/* Tetris project: logquery/logquery.cpp
+ *
+ * Log query file, aggregates the games of a game log
+ *
+ * Program author/editor:
+ * Name: Rasmus Kivinen
+ * Student number: 285870
+ * UserID: kivinenr
+ * E-Mail: rasmus.kivinen@tuni.fi
+ * */
+
+#include "logquery.hh"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+namespace
+{
+// Integer groups are counted in an array if their values are this close
+// to each other, otherwise a map is used
+const std::int64_t MAX_DENSE_GROUPS = 65536;
+}
+
+void LogQuery::Group::add(const Group& other)
+{
+    if(other.games == 0)
+    {
+        return;
+    }
+    score_min = games == 0 ? other.score_min : std::min(score_min, other.score_min);
+    score_max = games == 0 ? other.score_max : std::max(score_max, other.score_max);
+    games += other.games;
+    score += other.score;
+    pieces += other.pieces;
+    flips += other.flips;
+    drops += other.drops;
+    duration_ms += other.duration_ms;
+}
+
+LogQuery::LogQuery(const Settings& settings):
+    settings_(settings)
+{
+}
+
+bool LogQuery::run()
+{
+    if(GameLog::is_list_column(settings_.group))
+    {
+        error_ = "Can't group by a list column";
+        return false;
+    }
+    if(not reader_.open(settings_.filename))
+    {
+        error_ = reader_.error();
+        return false;
+    }
+    if(not reader_.error().empty())
+    {
+        std::cerr << reader_.error() << std::endl;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    //Every worker takes the next block until none are left and keeps its
+    //own groups, they are combined at the end
+    std::atomic<std::size_t> next_block(0);
+    std::atomic<std::size_t> damaged(0);
+    std::mutex result_mutex;
+    std::map<std::string, Group> result;
+
+    auto worker = [&]()
+    {
+        std::map<std::string, Group> groups;
+        std::size_t block;
+        while((block = next_block++) < reader_.blocks())
+        {
+            if(not aggregate_block(block, groups))
+            {
+                damaged += 1;
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(result_mutex);
+        for(const auto& group: groups)
+        {
+            result[group.first].add(group.second);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for(int i = 1; i < settings_.threads; i++)
+    {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for(auto& thread: threads)
+    {
+        thread.join();
+    }
+
+    double seconds = std::chrono::duration<double>(
+                std::chrono::steady_clock::now() - start).count();
+
+    print(result);
+
+    std::uint64_t games = 0;
+    for(const auto& group: result)
+    {
+        games += group.second.games;
+    }
+    std::cout << games << " games in " << reader_.blocks() << " blocks, "
+              << seconds << " s";
+    if(damaged > 0)
+    {
+        std::cout << ", " << damaged << " damaged blocks skipped";
+    }
+    std::cout << std::endl;
+
+    return true;
+}
+
+const std::string& LogQuery::error() const
+{
+    return error_;
+}
+
+bool LogQuery::aggregate_block(std::size_t block,
+                               std::map<std::string, Group>& groups) const
+{
+    std::size_t rows = reader_.rows(block);
+
+    //The group of each row as a number from 0 and the name of each group
+    std::vector<std::uint32_t> keys(rows);
+    std::vector<std::string> names;
+
+    if(GameLog::is_string_column(settings_.group))
+    {
+        std::vector<std::uint8_t> codes;
+        if(not reader_.read_strings(block, settings_.group, codes, names))
+        {
+            return false;
+        }
+        std::copy(codes.begin(), codes.end(), keys.begin());
+    }
+    else
+    {
+        std::vector<std::int64_t> values;
+        if(not reader_.read_integers(block, settings_.group, values))
+        {
+            return false;
+        }
+
+        std::int64_t min = rows > 0 ? *std::min_element(values.begin(), values.end()) : 0;
+        std::int64_t max = rows > 0 ? *std::max_element(values.begin(), values.end()) : 0;
+        if(std::uint64_t(max) - std::uint64_t(min) < MAX_DENSE_GROUPS)
+        {
+            for(std::size_t i = 0; i < rows; i++)
+            {
+                keys[i] = values[i] - min;
+            }
+            for(std::int64_t value = min; value <= max; value++)
+            {
+                names.push_back(std::to_string(value));
+            }
+        }
+        else
+        {
+            std::map<std::int64_t, std::uint32_t> numbers;
+            for(std::size_t i = 0; i < rows; i++)
+            {
+                auto number = numbers.insert({values[i], numbers.size()});
+                if(number.second)
+                {
+                    names.push_back(std::to_string(values[i]));
+                }
+                keys[i] = number.first->second;
+            }
+        }
+    }
+
+    std::vector<std::int64_t> scores;
+    std::vector<std::int64_t> flips;
+    std::vector<std::int64_t> drops;
+    std::vector<std::int64_t> durations;
+    std::vector<std::int64_t> pieces;
+    if(not reader_.read_integers(block, GameLog::SCORE, scores) ||
+       not reader_.read_integers(block, GameLog::FLIPS, flips) ||
+       not reader_.read_integers(block, GameLog::DROPS, drops) ||
+       not reader_.read_integers(block, GameLog::DURATION_MS, durations) ||
+       not reader_.read_lists(block, GameLog::PIECES, pieces, nullptr))
+    {
+        return false;
+    }
+
+    std::vector<Group> totals(names.size());
+    for(std::size_t i = 0; i < rows; i++)
+    {
+        Group& group = totals[keys[i]];
+        if(group.games == 0 || scores[i] < group.score_min)
+        {
+            group.score_min = scores[i];
+        }
+        if(group.games == 0 || scores[i] > group.score_max)
+        {
+            group.score_max = scores[i];
+        }
+        group.games += 1;
+        group.score += scores[i];
+        group.pieces += pieces[i];
+        group.flips += flips[i];
+        group.drops += drops[i];
+        group.duration_ms += durations[i];
+    }
+
+    for(std::size_t i = 0; i < names.size(); i++)
+    {
+        if(totals[i].games > 0)
+        {
+            groups[names[i]].add(totals[i]);
+        }
+    }
+    return true;
+}
+
+void LogQuery::print(const std::map<std::string, Group>& groups) const
+{
+    //Numbers are shown in numeric order instead of the order of the map
+    std::vector<std::pair<std::string, Group>> rows(groups.begin(), groups.end());
+    if(not GameLog::is_string_column(settings_.group))
+    {
+        std::sort(rows.begin(), rows.end(),
+                  [](const std::pair<std::string, Group>& a,
+                     const std::pair<std::string, Group>& b)
+                  { return std::stoll(a.first) < std::stoll(b.first); });
+    }
+
+    std::printf("%-14s %12s %10s %8s %8s %10s %8s %8s %12s\n",
+                GameLog::column_name(settings_.group).c_str(), "games",
+                "mean score", "min", "max", "pieces", "flips", "drops", "duration s");
+    for(const auto& row: rows)
+    {
+        const Group& group = row.second;
+        double games = group.games;
+        std::printf("%-14s %12llu %10.2f %8lld %8lld %10.2f %8.2f %8.2f %12.2f\n",
+                    row.first.c_str(), static_cast<unsigned long long>(group.games),
+                    group.score / games, static_cast<long long>(group.score_min),
+                    static_cast<long long>(group.score_max), group.pieces / games,
+                    group.flips / games, group.drops / games,
+                    group.duration_ms / games / 1000);
+    }
+}
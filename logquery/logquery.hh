@@ -0,0 +1,74 @@
+/* Tetris project: logquery/logquery.hh
+ *
+ * Header file for the log query, groups the games of a game log by a
+ * column and calculates averages of the others for each group, e.g. the
+ * mean score by difficulty. Blocks are aggregated in parallel and only
+ * the columns used by the query are decoded.
+ *
+ * Program author/editor:
+ * Name: Rasmus Kivinen
+ * Student number: 285870
+ * UserID: kivinenr
+ * E-Mail: rasmus.kivinen@tuni.fi
+ * */
+
+#ifndef LOGQUERY_HH
+#define LOGQUERY_HH
+
+#include "gamelog.hh"
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+class LogQuery
+{
+public:
+    struct Settings
+    {
+        std::string filename;
+        // Column whose values form the groups
+        GameLog::Column group = GameLog::DIFFICULTY;
+        int threads = 1;
+    };
+
+    // Totals of the games of one group
+    struct Group
+    {
+        std::uint64_t games = 0;
+        std::int64_t score = 0;
+        std::int64_t score_min = 0;
+        std::int64_t score_max = 0;
+        std::int64_t pieces = 0;
+        std::int64_t flips = 0;
+        std::int64_t drops = 0;
+        std::int64_t duration_ms = 0;
+
+        void add(const Group& other);
+    };
+
+    explicit LogQuery(const Settings& settings);
+
+    /**
+     * @brief run Reads the log and prints a row for each group
+     * @return false if the log couldn't be read
+     */
+    bool run();
+
+    const std::string& error() const;
+
+private:
+    /**
+     * @brief aggregate_block Adds the games of a block to the groups
+     * @return false if the block is damaged
+     */
+    bool aggregate_block(std::size_t block, std::map<std::string, Group>& groups) const;
+
+    void print(const std::map<std::string, Group>& groups) const;
+
+    Settings settings_;
+    GameLogReader reader_;
+    std::string error_;
+};
+
+#endif // LOGQUERY_HH
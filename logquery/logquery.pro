@@ -0,0 +1,25 @@
+#-------------------------------------------------
+#
+# Queries the game log, e.g. the mean score
+# by difficulty
+#
+#-------------------------------------------------
+
+TARGET = tetrislogquery
+TEMPLATE = app
+
+CONFIG += console c++14 thread
+CONFIG -= app_bundle qt
+
+INCLUDEPATH += ..
+
+SOURCES += \
+        main.cpp \
+        logquery.cpp \
+        ../gamelog.cpp \
+        ../memorytracker.cpp
+
+HEADERS += \
+        logquery.hh \
+        ../gamelog.hh \
+        ../memorytracker.hh
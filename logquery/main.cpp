@@ -0,0 +1,75 @@
+/* Tetris project: logquery/main.cpp
+ *
+ * Main function of the log query. Usage:
+ *   tetrislogquery LOG [--group COLUMN] [--threads N]
+ *
+ * COLUMN is difficulty (the default), source, piece_mode or any other
+ * column that isn't a list, e.g. seed.
+ *
+ * Program author/editor:
+ * Name: Rasmus Kivinen
+ * Student number: 285870
+ * UserID: kivinenr
+ * E-Mail: rasmus.kivinen@tuni.fi
+ * */
+
+#include "logquery.hh"
+#include <iostream>
+#include <string>
+#include <thread>
+
+int main(int argc, char *argv[])
+{
+    LogQuery::Settings settings;
+    settings.threads = std::max(1u, std::thread::hardware_concurrency());
+
+    for(int i = 1; i < argc; i++)
+    {
+        std::string option = argv[i];
+        if(option.compare(0, 2, "--") != 0)
+        {
+            settings.filename = option;
+            continue;
+        }
+        if(i + 1 >= argc)
+        {
+            std::cerr << "Missing value for " << option << std::endl;
+            return 1;
+        }
+        std::string value = argv[++i];
+
+        if(option == "--group")
+        {
+            settings.group = GameLog::column_from_name(value);
+            if(settings.group == GameLog::NUMBER_OF_COLUMNS)
+            {
+                std::cerr << "Unknown column " << value << std::endl;
+                return 1;
+            }
+        }
+        else if(option == "--threads")
+        {
+            settings.threads = std::stoi(value);
+        }
+        else
+        {
+            std::cerr << "Unknown option " << option << std::endl;
+            return 1;
+        }
+    }
+
+    if(settings.filename.empty())
+    {
+        std::cerr << "Give a game log" << std::endl;
+        return 1;
+    }
+
+    LogQuery query(settings);
+    if(not query.run())
+    {
+        std::cerr << query.error() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
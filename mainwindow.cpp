@@ -11,8 +11,15 @@
 
 #include "mainwindow.hh"
 #include "ui_mainwindow.h"
-#include <QDebug>
+#include <QDateTime>
+#include <QFileDialog>
+#include <QFontDatabase>
+#include <QMouseEvent>
+#include <QPixmap>
+#include <random>
 #include <set>
+#include <sstream>
+#include <ctime>
 
 MainWindow::MainWindow(QWidget *parent) :
     QMainWindow(parent),
@@ -43,40 +50,93 @@ MainWindow::MainWindow(QWidget *parent) :
     // if its upper left corner is inside the sceneRect.
     scene_->setSceneRect(0, 0, BORDER_RIGHT - 1, BORDER_DOWN - 1);
 
-    // Setting random engine ready for the first real call.
-    int seed = time(0); // You can change seed value for testing purposes
-    randomEng.seed(seed);
-    distr = std::uniform_int_distribution<int>(0, NUMBER_OF_TETROMINOS - 1);
-    distr(randomEng); // Wiping out the first random number (which is almost always 0)
-    // After the above settings, you can use randomEng to draw the next falling
-    // tetromino by calling: distr(randomEng) in a suitable method.
-
     // Add more initial settings and connect calls, when needed.
 
-    // Setting the background's color and pattern
-    QLinearGradient gradient(MIDDLE_X, 0, BORDER_DOWN, MIDDLE_X);
-    gradient.setColorAt(0, Qt::white);
-    gradient.setColorAt(1, Qt::black);
-    QBrush brush(gradient);
-    scene_->setBackgroundBrush(brush);
+    // Setting the background's color and pattern, the same one is used
+    // when exporting replays to images
+    scene_->setBackgroundBrush(BoardRenderer::background_brush());
 
 
     // Connect the two timers used to their respective functions
-    connect(&gravity_timer, &QTimer::timeout, this, &MainWindow::drop_all);
     connect(&time_played_timer, &QTimer::timeout, this, &MainWindow::tick_time);
 
-    //Start button is disabled until difficulty is selected
+    // The game itself runs on the game thread. Every time it publishes a
+    // new snapshot, drawing it is queued to the thread of the window, so
+    // nothing is drawn when the board doesn't change.
+    game_thread_.set_publish_callback([this]()
+    {
+        if(not render_queued_.exchange(true))
+        {
+            QMetaObject::invokeMethod(this, "render_snapshot", Qt::QueuedConnection);
+        }
+    });
+
+    // The versus thread is drawn the same way, with a render of its own
+    versus_thread_.set_publish_callback([this]()
+    {
+        if(not versus_render_queued_.exchange(true))
+        {
+            QMetaObject::invokeMethod(this, "render_versus_snapshot", Qt::QueuedConnection);
+        }
+    });
+
+    // The background never changes, so the view draws it only once
+    ui->graphicsView->setCacheMode(QGraphicsView::CacheBackground);
+
+    ui->dasSpinBox->setValue(das_ms_);
+    ui->arrSpinBox->setValue(arr_ms_);
+
+    //Start and versus buttons are disabled until difficulty is selected
     ui->startPushButton->setEnabled(false);
+    ui->versusPushButton->setEnabled(false);
 
     //Submit score button is disabled until game is over
     ui->submitscorePushButton->setEnabled(false);
 
     ui->gameoverLabel->hide();
+    ui->replaySlider->setEnabled(false);
+
+    //The puzzle is edited by clicking the cells of the board, and it can
+    //only be changed when the puzzle mode is on
+    ui->graphicsView->viewport()->installEventFilter(this);
+    connect(&puzzle_timer_, &QTimer::timeout, this, &MainWindow::update_puzzle_progress);
+    connect(&solution_timer_, &QTimer::timeout, this, &MainWindow::show_solution_step);
+    set_puzzle_editable(false);
+    ui->solvePushButton->setEnabled(false);
+
+    //The memory panel is only there when the counting is compiled in
+    if(MemoryTracker::enabled())
+    {
+        ui->memoryTextBrowser->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+        connect(&memory_timer_, &QTimer::timeout, this, &MainWindow::update_memory_panel);
+        memory_latest_ = MemoryTracker::snapshot();
+        memory_clock_.start();
+        memory_timer_.start(1000);
+    }
+    else
+    {
+        ui->memoryTextBrowser->hide();
+        ui->memorydumpPushButton->hide();
+    }
+
     readhiscore();
 }
 
 MainWindow::~MainWindow()
 {
+    game_thread_.stop();
+    versus_thread_.stop();
+    solver_.cancel();
+    solver_.wait();
+    game_log_.close();
+
+    //The counts at the end of the session are always dumped
+    if(MemoryTracker::enabled())
+    {
+        update_memory_panel();
+        MemoryTracker::write_dump("tetrismemory.txt", memory_latest_,
+                                  memory_previous_, memory_seconds_);
+    }
     delete ui;
 }
 
@@ -94,333 +154,259 @@ QGraphicsRectItem* MainWindow::add_block(int x, int y, QColor color)
     return block;
 }
 
-void MainWindow::move_block(std::vector<QGraphicsRectItem*> shape, std::string dir)
+void MainWindow::render_snapshot()
 {
-    if(not shape_can_move(shape, dir))
-    {
-        return;
-    }
+    MemoryScope scope(MemoryTracker::RENDERING);
+    render_queued_ = false;
 
-    //Move every block of the shape in the specified direction
-    for(auto block_item: shape)
+    //Nothing is drawn if the game hasn't changed
+    if(not game_thread_.update_snapshot())
     {
-        QPoint point = new_location(block_item, dir);
-        block_item->setPos(point);
+        return;
     }
 
-}
+    const Game::Snapshot& snapshot = game_thread_.snapshot();
+    update_scene(snapshot.board);
 
-void MainWindow::drop_all()
-{
-    //If the latest tetromino can't move any further down, create a new one
-    if(not shape_can_move(tetrominos.back(), "DOWN"))
-    {
-        for(auto shape: tetrominos)
-        {
-            move_block(shape,"DOWN");
-        }
+    //Update the score
+    score_ = snapshot.board.score();
+    ui->blocksnumberLabel->setText(QString::number(score_));
 
-        create_random_tetromino();
-    }
+    //Show the upcoming tetrominos
+    show_next(snapshot.preview);
 
-    else
+    if(snapshot.game_over)
     {
-        for(auto shape: tetrominos)
-        {
-            move_block(shape,"DOWN");
-        }
+        game_over();
     }
-
 }
 
-QPoint MainWindow::new_location(QGraphicsRectItem *block, std::string dir)
+void MainWindow::render_versus_snapshot()
 {
-    int curr_x = block->x();
-    int curr_y = block->y();
+    MemoryScope scope(MemoryTracker::RENDERING);
+    versus_render_queued_ = false;
 
-    QPoint new_location;
-
-    if(dir == "DOWN")
+    //The thread keeps answering the opponent for a while after the game
+    //is over, those snapshots aren't drawn anymore
+    if(not versus_thread_.update_snapshot() || versus_over_)
     {
-        new_location = QPoint(curr_x, curr_y + SQUARE_SIDE);
+        return;
     }
 
-    if(dir == "LEFT")
-    {
-        new_location = QPoint(curr_x - SQUARE_SIDE, curr_y);
-    }
+    const VersusThread::Snapshot& snapshot = versus_thread_.snapshot();
+    update_scene(snapshot.board);
+    score_ = snapshot.board.score();
+    ui->blocksnumberLabel->setText(QString::number(score_));
+    show_next(snapshot.preview);
 
-    if(dir == "RIGHT")
+    opponent_renderer_.render(snapshot.opponent_board, opponent_image_);
+    ui->opponentLabel->setPixmap(QPixmap::fromImage(
+            opponent_image_.scaled(BoardRenderer::WIDTH / 2, BoardRenderer::HEIGHT / 2,
+                                   Qt::IgnoreAspectRatio, Qt::SmoothTransformation)));
+
+    switch(snapshot.status)
     {
-        new_location = QPoint(curr_x + SQUARE_SIDE, curr_y);
+    case RollbackSession::CONNECTING:
+        ui->versusstatusLabel->setText("Waiting for the opponent on port "
+                                       + QString::number(ui->peerportSpinBox->value()));
+        break;
+    case RollbackSession::PLAYING:
+    case RollbackSession::STALLED:
+        ui->versusstatusLabel->setText(
+                    "Rollbacks: " + QString::number(snapshot.stats.rollbacks)
+                    + ", longest " + QString::number(snapshot.stats.max_rollback)
+                    + " ticks"
+                    + (snapshot.status == RollbackSession::STALLED ?
+                           "\nWaiting for the opponent" : ""));
+        break;
+    case RollbackSession::OVER:
+        versus_game_over(snapshot);
+        break;
     }
-
-    return new_location;
 }
 
-void MainWindow::create_random_tetromino()
+void MainWindow::update_scene(const Board& board)
 {
-    //If the spawning area for the new block is occupied, the game ends
-    if(not block_can_move(QPoint(MIDDLE_X, BORDER_UP)) ||
-       not block_can_move(QPoint(MIDDLE_X, BORDER_UP + SQUARE_SIDE)))
-    {
-        game_over();
-        return;
-    }
-
-    //Create vector to contain all individual squares of the tetromino
-    std::vector<QGraphicsRectItem*> shape;
-
-    //Get random number for tetromino creation, assign the color associated
-    //with that number
-    int tetromino_number = distr(randomEng);
-    QColor color = colors.at(tetromino_number);
+    const std::vector<Board::Tetromino>& shapes = board.tetrominos();
 
-    int length;
-
-
-    //Create blocks based on tetromino_number and add them to the vector
-    //If the shape is simple, this is done using for loops, otherwise
-    //create the new blocks manually
-    if(tetromino_number == 0)
+    //A replay can go backwards, so there can be more squares than
+    //there are tetrominos
+    while(tetrominos.size() > shapes.size())
     {
-        length = SQUARE_SIDE * 4;
-        for(int x = MIDDLE_X - length/2;
-            x < MIDDLE_X + length/2; x += SQUARE_SIDE)
+        for(auto block: tetrominos.back())
         {
-            QGraphicsRectItem* block = add_block(x, BORDER_UP, color);
-
-            shape.push_back(block);
+            delete block;
         }
+        tetrominos.pop_back();
     }
 
-    if(tetromino_number == 1)
+    for(std::size_t i = 0; i < shapes.size(); i++)
     {
-        QGraphicsRectItem* block = add_block(MIDDLE_X - SQUARE_SIDE, BORDER_UP, color);
+        const Board::Tetromino& shape = shapes.at(i);
 
-        shape.push_back(block);
-
-        for(int x = MIDDLE_X - SQUARE_SIDE;
-            x < MIDDLE_X + 2 * SQUARE_SIDE; x += SQUARE_SIDE)
+        //New tetrominos get their squares created, the old ones are moved
+        //to where the board has them
+        if(i == tetrominos.size())
         {
-            QGraphicsRectItem* block = add_block(x, BORDER_UP + SQUARE_SIDE, color);
-
-            shape.push_back(block);
+            std::vector<QGraphicsRectItem*> blocks;
+            for(auto block: shape.blocks)
+            {
+                blocks.push_back(add_block(block.x * SQUARE_SIDE,
+                                           block.y * SQUARE_SIDE,
+                                           colors.at(shape.kind)));
+            }
+            tetrominos.push_back(blocks);
+            continue;
         }
-    }
-
-    if(tetromino_number == 2)
-    {
-        QGraphicsRectItem* block = add_block(MIDDLE_X + SQUARE_SIDE, BORDER_UP, color);
 
-        shape.push_back(block);
-
-        for(int x = MIDDLE_X - SQUARE_SIDE;
-            x < MIDDLE_X + 2 * SQUARE_SIDE; x += SQUARE_SIDE)
+        for(int j = 0; j < Board::BLOCKS_PER_TETROMINO; j++)
         {
-            QGraphicsRectItem* block = add_block(x, BORDER_UP + SQUARE_SIDE, color);
-
-            shape.push_back(block);
+            tetrominos.at(i).at(j)->setPos(shape.blocks.at(j).x * SQUARE_SIDE,
+                                           shape.blocks.at(j).y * SQUARE_SIDE);
         }
     }
+}
 
-    if(tetromino_number == 3)
+void MainWindow::clear_scene()
+{
+    MemoryScope scope(MemoryTracker::RENDERING);
+    for(auto shape: tetrominos)
     {
-        for(int x = MIDDLE_X - SQUARE_SIDE; x
-            < MIDDLE_X +  SQUARE_SIDE; x += SQUARE_SIDE)
+        for(auto block: shape)
         {
-            for(int y = BORDER_UP;
-                y < BORDER_UP + 2* SQUARE_SIDE; y+= SQUARE_SIDE)
-            {
-                QGraphicsRectItem* block = add_block(x, y, color);
-
-                shape.push_back(block);
-            }
+            delete block;
         }
     }
+    tetrominos.clear();
+}
 
-    if(tetromino_number == 4)
+void MainWindow::show_next(const std::array<std::uint8_t, PieceGenerator::PREVIEW_SIZE>& preview)
+{
+    QString next = "Next: ";
+    for(auto kind: preview)
     {
-        QGraphicsRectItem* block1 = add_block(MIDDLE_X, BORDER_UP, color);
-
-        shape.push_back(block1);
-
-        QGraphicsRectItem* block2 = add_block(MIDDLE_X + SQUARE_SIDE,
-                                              BORDER_UP, color);
-
-        shape.push_back(block2);
-
-        QGraphicsRectItem* block3 = add_block(MIDDLE_X,
-                                              BORDER_UP + SQUARE_SIDE, color);
-
-        shape.push_back(block3);
-
-        QGraphicsRectItem* block4 = add_block(MIDDLE_X - SQUARE_SIDE,
-                                             BORDER_UP + SQUARE_SIDE, color);
-
-        shape.push_back(block4);
+        next += Board::TETROMINO_LETTERS[kind];
+        next += " ";
     }
+    ui->nextLabel->setText(next);
+}
 
-    if(tetromino_number == 5)
-    {
-        QGraphicsRectItem* block = add_block(MIDDLE_X, BORDER_UP, color);
-
-        shape.push_back(block);
-
-        for(int x = MIDDLE_X - SQUARE_SIDE;
-            x < MIDDLE_X + 2 * SQUARE_SIDE; x += SQUARE_SIDE)
-        {
-            QGraphicsRectItem* block =
-                    add_block(x, BORDER_UP + SQUARE_SIDE, color);
+void MainWindow::show_replay_frame(quint64 frame)
+{
+    MemoryScope scope(MemoryTracker::RENDERING);
 
-            shape.push_back(block);
-        }
+    //Moving forward a little continues from the shown frame,
+    //otherwise the board is loaded from the keyframe before the frame
+    bool success;
+    if(frame >= replay_cursor_.frame &&
+       frame - replay_cursor_.frame < replay_reader_.keyframe_interval())
+    {
+        success = replay_reader_.advance(frame, replay_board_, replay_cursor_);
     }
-
-    if(tetromino_number == 6)
+    else
     {
-        QGraphicsRectItem* block1 =
-                add_block(MIDDLE_X, BORDER_UP, color);
-
-        shape.push_back(block1);
-
-        QGraphicsRectItem* block2 =
-                add_block(MIDDLE_X - SQUARE_SIDE, BORDER_UP, color);
-
-        shape.push_back(block2);
-
-        QGraphicsRectItem* block3 =
-                add_block(MIDDLE_X, BORDER_UP + SQUARE_SIDE, color);
-
-        shape.push_back(block3);
-
-        QGraphicsRectItem* block4 =
-                add_block(MIDDLE_X + SQUARE_SIDE,
-                                             BORDER_UP + SQUARE_SIDE, color);
-
-        shape.push_back(block4);
+        success = replay_reader_.seek(frame, replay_board_, replay_cursor_);
     }
 
-    //Add the created vector (tetromino) to vector of all tetrominos
-    tetrominos.push_back(shape);
-
-    //Update the score
-    score_ += 4;
-    ui->blocksnumberLabel->setText(QString::number(score_));
-
-    //Speeds up the falling rate of the blocks (up to specified point)
-    if(gravity_timer.interval() > MAXIMUM_SPEED)
+    if(not success)
     {
-        gravity_timer.setInterval(gravity_timer.interval() * SPEED_CHANGE_RATE);
+        ui->statusBar->showMessage("The replay is damaged");
+        return;
     }
 
+    update_scene(replay_board_);
+    ui->blocksnumberLabel->setText(QString::number(replay_board_.score()));
 
-
-
-
+    int seconds = frame * replay_reader_.frame_ms() / 1000;
+    ui->replaytimeLabel->setText(QString::number(seconds / 60) + " min "
+                                 + QString::number(seconds % 60) + " sec");
 }
 
-bool MainWindow::block_can_move(QPoint point)
+void MainWindow::show_puzzle()
 {
-    //Checks if a block can move to the specified point
-    //(no other blocks are there and it is inside the game boundaries)
-    if(not scene_->sceneRect().contains(point))
-    {
-        return false;
-    }
+    clear_scene();
+    update_scene(puzzle_.board());
+    ui->blocksnumberLabel->setText("0");
+    ui->puzzlestatusLabel->setText("Fill " + QString::number(puzzle_.target_rows())
+                                   + " rows with " + QString::number(puzzle_.pieces().size())
+                                   + " tetrominos");
+}
 
+void MainWindow::set_puzzle_editable(bool editable)
+{
+    ui->importpuzzlePushButton->setEnabled(editable);
+    ui->piecesLineEdit->setEnabled(editable);
+    ui->puzzlerowsSpinBox->setEnabled(editable);
+}
 
+void MainWindow::game_over()
+{
+    //Color all blocks gray
+    QBrush brush = QBrush();
+    brush.setStyle(Qt::SolidPattern);
+    brush.setColor(Qt::gray);
     for(auto shape: tetrominos)
     {
-        for(auto rect: shape)
+        for(auto block: shape)
         {
-            if(rect->x() == point.x() && rect->y() == point.y())
-            {
-                return false;
-            }
+            block->setBrush(brush);
         }
     }
-    return true;
 
-}
+    game_thread_.stop();
+    time_played_timer.stop();
 
-void MainWindow::drop_current()
-{
-    //Command the block to move down as many times as there are rows
-    //on the board
-    for(int i = 0; i <= BORDER_DOWN / SQUARE_SIDE; i++)
+    //The game thread only wakes up when something happens, the number of
+    //wakeups per second tells how well it stayed asleep
+    const Game::Snapshot& snapshot = game_thread_.snapshot();
+    double game_seconds = snapshot.frame * Game::FRAME_MS / 1000.0;
+    QString stats_text = "Wakeups: "
+            + QString::number(game_thread_.wakeups() / qMax(game_seconds, 1.0), 'f', 1)
+            + " per second";
+    if(snapshot.latency_max_ns > 0)
     {
-        move_block(tetrominos.back(), "DOWN");
+        stats_text += ", input latency: average "
+                + QString::number(snapshot.latency_average_ns / 1000000.0, 'f', 2)
+                + " ms, max "
+                + QString::number(snapshot.latency_max_ns / 1000000.0, 'f', 2) + " ms";
     }
-}
 
-bool MainWindow::shape_can_move(std::vector<QGraphicsRectItem*> shape, std::string dir)
-{
-    for(auto block:shape)
+    //Every finished game is added to the statistics of all games
+    GameLog::Record record = game_thread_.record();
+    record.source = "player";
+    record.difficulty = difficulty_;
+    record.start_time_ms = game_start_time_ms_;
+    if((not game_log_.is_open() && not game_log_.open("tetrisgames.log")) ||
+       not game_log_.append(record))
     {
-        QPoint point = new_location(block, dir);
-        if(not block_can_move(point))
-        {
-            //If there is a block taking up the space, check if
-            //the block belongs to the same tetromino
-            //(the block will naturally move in the same direction)
-            bool occupied_by_buddy = false;
-
-            for(auto testblock: shape)
-            {
-                if(QPoint(testblock->x(), testblock->y()) == point)
-                {
-                    occupied_by_buddy = true;
-                }
-            }
-            if(occupied_by_buddy == false)
-            {
-                return false;
-            }
-        }
+        stats_text += ", could not write tetrisgames.log";
     }
-    return true;
-}
 
-void MainWindow::flip_shape()
-{
-    //Note: only works with shapes that are 2 blocks high since it mirrors
-    //them vertically
+    ui->statusBar->showMessage(stats_text);
 
-    //Define higher_y as the lowest point on the board
-    qreal higher_y = BORDER_DOWN;
+    ui->gameoverLabel->show();
 
-    //Find the highest point of the shape
-    for(auto block: tetrominos.back())
-    {
-        if(block->y() <= higher_y)
-        {
-            higher_y = block->y();
-            QPoint newpoint = QPoint(block->x(), block->y() + 2 * SQUARE_SIDE);
-            if(not block_can_move(newpoint))
-            {
-                return;
-            }
-        }
-    }
+    ui->playernameLineEdit->setEnabled(true);
+    ui->submitscorePushButton->setEnabled(true);
 
-    for(auto block:tetrominos.back())
-    {
-        //If the block is on the higher row, move it below the lower row
-        if(block->y() == higher_y)
-        {
-            block->setY(block->y() + 2 * SQUARE_SIDE);
-        }
+    releaseKeyboard();
+
+
+    ui->leftPushButton->setDisabled(true);
+    ui->rightPushButton->setDisabled(true);
+    ui->downPushButton->setDisabled(true);
+    ui->dropPushButton->setDisabled(true);
+    ui->startPushButton->setDisabled(true);
+    ui->comboBox->setDisabled(true);
+    ui->flipPushButton->setDisabled(true);
+    ui->openreplayPushButton->setEnabled(true);
 
-        //Move the whole shape up to avoid it falling faster
-        //because of the flip
-        block->setY(block->y() - SQUARE_SIDE);
-    }
 }
 
-void MainWindow::game_over()
+void MainWindow::versus_game_over(const VersusThread::Snapshot& snapshot)
 {
-    //Color all blocks gray
+    versus_over_ = true;
+
     QBrush brush = QBrush();
     brush.setStyle(Qt::SolidPattern);
     brush.setColor(Qt::gray);
@@ -431,30 +417,37 @@ void MainWindow::game_over()
             block->setBrush(brush);
         }
     }
-
-    gravity_timer.stop();
     time_played_timer.stop();
 
-    ui->gameoverLabel->show();
+    QString result = snapshot.result > 0 ? "You won" :
+                     snapshot.result < 0 ? "You lost" : "Draw";
+    ui->versusstatusLabel->setText(result);
 
-    ui->playernameLineEdit->setEnabled(true);
-    ui->submitscorePushButton->setEnabled(true);
+    //Desyncs should never happen, the same buttons give the same game
+    const RollbackSession::Stats& stats = snapshot.stats;
+    QString stats_text = result + ", rollbacks: " + QString::number(stats.rollbacks)
+            + " (" + QString::number(stats.resimulated_ticks) + " ticks replayed, longest "
+            + QString::number(stats.max_rollback) + "), stalls: "
+            + QString::number(stats.stalls) + ", desyncs: "
+            + QString::number(stats.desyncs);
+    ui->statusBar->showMessage(stats_text);
 
+    //Versus games have no hiscores, replays or game log rows
+    ui->gameoverLabel->show();
     releaseKeyboard();
 
-
     ui->leftPushButton->setDisabled(true);
     ui->rightPushButton->setDisabled(true);
     ui->downPushButton->setDisabled(true);
     ui->dropPushButton->setDisabled(true);
-    ui->startPushButton->setDisabled(true);
-    ui->comboBox->setDisabled(true);
     ui->flipPushButton->setDisabled(true);
-
+    ui->comboBox->setDisabled(true);
+    ui->openreplayPushButton->setEnabled(true);
 }
 
 void MainWindow::readhiscore()
 {
+    MemoryScope scope(MemoryTracker::PERSISTENCE);
     ui->hiscoreTextBrowser->clear();
 
     std::ifstream infile("tetrishiscore.txt");
@@ -527,6 +520,7 @@ void MainWindow::writehiscore()
         return;
     }
 
+    MemoryScope scope(MemoryTracker::PERSISTENCE);
     std::string name = ui->playernameLineEdit->text().toStdString();
     std::string score = std::to_string(score_);
 
@@ -539,6 +533,12 @@ void MainWindow::writehiscore()
 
 void MainWindow::tick_time()
 {
+    //After a pause the first tick only waited for the rest of the second
+    if(time_played_timer.interval() != 1000)
+    {
+        time_played_timer.start(1000);
+    }
+
     time_played_sec_ += 1;
     if(time_played_sec_ > 60)
     {
@@ -552,61 +552,112 @@ void MainWindow::tick_time()
 
 }
 
+Game::Input MainWindow::input_for_key(int key) const
+{
+    switch(key)
+    {
+    case Qt::Key_Left:
+        return Game::INPUT_LEFT;
+    case Qt::Key_Right:
+        return Game::INPUT_RIGHT;
+    case Qt::Key_Down:
+        return Game::INPUT_DOWN;
+    case Qt::Key_Space:
+        return Game::INPUT_FLIP;
+    case Qt::Key_Control:
+        return Game::INPUT_DROP;
+    default:
+        return Game::NUMBER_OF_INPUTS;
+    }
+}
+
+void MainWindow::send_input(Game::Input input, bool pressed)
+{
+    //The buttons of the versus game are in the same order as the inputs
+    if(versus_)
+    {
+        versus_thread_.set_button(VersusGame::Button(1 << input), pressed);
+        return;
+    }
+    game_thread_.push_input(input, pressed);
+}
+
 void MainWindow::set_difficulty(int diff)
 {
     //Difficulty level sets the interval with which the blocks
     //fall 1 step. The interval is difficulty² * 50
     //where 1 <= difficulty <= 4
     timerinterval_ = timerinterval_ - (diff*diff*50);
+    difficulty_ = diff;
 }
 
 
-void MainWindow::on_downPushButton_clicked()
-{
-    move_block(tetrominos.back(), "DOWN");
-
-    //Restart timer so it wont tick immediately after pressing down
-    gravity_timer.start();
-}
-
 void MainWindow::on_leftPushButton_clicked()
 {
-    move_block(tetrominos.back(), "LEFT");
+    send_input(Game::INPUT_LEFT, true);
+    send_input(Game::INPUT_LEFT, false);
 }
 
 void MainWindow::on_rightPushButton_clicked()
 {
-    move_block(tetrominos.back(), "RIGHT");
+    send_input(Game::INPUT_RIGHT, true);
+    send_input(Game::INPUT_RIGHT, false);
 }
 
 void MainWindow::on_startPushButton_clicked()
 {
-    create_random_tetromino();
+    //A replay that was being viewed is replaced by the new game
+    replay_reader_.close();
+    ui->replaySlider->setEnabled(false);
+    ui->openreplayPushButton->setDisabled(true);
+    clear_scene();
+
+    game_start_time_ms_ = QDateTime::currentMSecsSinceEpoch();
+
+    Game::Settings settings;
+    settings.gravity_interval_ms = timerinterval_;
+    settings.das_ms = das_ms_;
+    settings.arr_ms = arr_ms_;
+    settings.seed = time(0); // You can change seed value for testing purposes
+    settings.piece_mode = ui->bagCheckBox->isChecked() ? PieceGenerator::BAG :
+                                                         PieceGenerator::UNIFORM;
+
+    //Every game is recorded
+    QString replay_name = "tetrisreplay_"
+            + QDateTime::currentDateTime().toString("yyyyMMdd_hhmmss") + ".ttr";
+    settings.replay_filename = replay_name.toStdString();
+
+    if(not game_thread_.start(settings))
+    {
+        ui->statusBar->showMessage("Could not create " + replay_name);
+    }
+
+    versus_ = false;
+    paused_ = false;
+    render_snapshot();
 
-    gravity_timer.start(timerinterval_);
     time_played_timer.start(1000);
 
     ui->startPushButton->setDisabled(true);
+    ui->versusPushButton->setDisabled(true);
     ui->playernameLineEdit->setDisabled(true);
+    ui->bagCheckBox->setDisabled(true);
+    ui->puzzleCheckBox->setDisabled(true);
 
     grabKeyboard();
 }
 
 void MainWindow::on_downPushButton_pressed()
 {
-    //Speeds up the falling of the blocks as long as
-    //the down pushbutton is held
-    timerinterval_ = gravity_timer.interval();
-    gravity_timer.setInterval(50);
+    //Holding the down pushbutton works like holding the down key
+    send_input(Game::INPUT_DOWN, true);
 }
 
 void MainWindow::on_downPushButton_released()
 {
-    gravity_timer.setInterval(timerinterval_);
+    send_input(Game::INPUT_DOWN, false);
 }
 
-
-
 void MainWindow::on_submitscorePushButton_clicked()
 {
     writehiscore();
@@ -622,54 +673,422 @@ void MainWindow::on_comboBox_currentIndexChanged(int index)
     if(index == 0)
     {
         ui->startPushButton->setEnabled(false);
+        ui->versusPushButton->setEnabled(false);
     }
 
     else
     {
         set_difficulty(index);
-        ui->startPushButton->setEnabled(true);
+        ui->startPushButton->setEnabled(not ui->puzzleCheckBox->isChecked());
+        ui->versusPushButton->setEnabled(not ui->puzzleCheckBox->isChecked());
     }
 }
 
 void MainWindow::on_dropPushButton_clicked()
 {
-    drop_current();
+    send_input(Game::INPUT_DROP, true);
+    send_input(Game::INPUT_DROP, false);
 }
 
 void MainWindow::on_flipPushButton_clicked()
 {
-    flip_shape();
+    send_input(Game::INPUT_FLIP, true);
+    send_input(Game::INPUT_FLIP, false);
 }
 
-void MainWindow::keyPressEvent(QKeyEvent *event)
+void MainWindow::on_dasSpinBox_valueChanged(int value)
+{
+    das_ms_ = value;
+    game_thread_.set_repeat(das_ms_, arr_ms_);
+}
+
+void MainWindow::on_arrSpinBox_valueChanged(int value)
+{
+    arr_ms_ = value;
+    game_thread_.set_repeat(das_ms_, arr_ms_);
+}
+
+void MainWindow::update_memory_panel()
+{
+    memory_seconds_ = memory_clock_.restart() / 1000.0;
+    memory_previous_ = memory_latest_;
+    memory_latest_ = MemoryTracker::snapshot();
+    ui->memoryTextBrowser->setPlainText(QString::fromStdString(
+            MemoryTracker::report(memory_latest_, memory_previous_, memory_seconds_)));
+}
+
+void MainWindow::on_memorydumpPushButton_clicked()
+{
+    update_memory_panel();
+    if(MemoryTracker::write_dump("tetrismemory.txt", memory_latest_,
+                                 memory_previous_, memory_seconds_))
+    {
+        ui->statusBar->showMessage("Memory use added to tetrismemory.txt");
+    }
+    else
+    {
+        ui->statusBar->showMessage("Could not write tetrismemory.txt");
+    }
+}
+
+void MainWindow::on_openreplayPushButton_clicked()
+{
+    QString filename = QFileDialog::getOpenFileName(this, "Open replay", "",
+                                                    "Replays (*.ttr)");
+    if(filename.isEmpty())
+    {
+        return;
+    }
+
+    if(not replay_reader_.open(filename.toStdString()))
+    {
+        ui->statusBar->showMessage(QString::fromStdString(replay_reader_.error()));
+        return;
+    }
+
+    //The squares of the previous game are gray, the replay is drawn
+    //from an empty scene
+    clear_scene();
+    if(not replay_reader_.seek(0, replay_board_, replay_cursor_))
+    {
+        ui->statusBar->showMessage("The replay is damaged");
+        return;
+    }
+
+    ui->gameoverLabel->hide();
+    ui->replaySlider->blockSignals(true);
+    ui->replaySlider->setRange(0, replay_reader_.frames() - 1);
+    ui->replaySlider->setValue(0);
+    ui->replaySlider->blockSignals(false);
+    ui->replaySlider->setEnabled(true);
+    show_replay_frame(0);
+}
+
+void MainWindow::on_replaySlider_valueChanged(int value)
+{
+    show_replay_frame(value);
+}
+
+void MainWindow::on_versusPushButton_clicked()
+{
+    replay_reader_.close();
+    ui->replaySlider->setEnabled(false);
+    ui->openreplayPushButton->setDisabled(true);
+    clear_scene();
+
+    //Both programs choose a random half of the seed, the one with the
+    //lower port decides the difficulty and the 7-bag
+    RollbackSession::Settings settings;
+    settings.link.local_port = ui->localportSpinBox->value();
+    settings.link.peer_port = ui->peerportSpinBox->value();
+    settings.link.latency_ms = ui->latencySpinBox->value();
+    settings.link.loss_percent = ui->lossSpinBox->value();
+    settings.gravity_interval_ms = timerinterval_;
+    settings.piece_mode = ui->bagCheckBox->isChecked() ? PieceGenerator::BAG :
+                                                         PieceGenerator::UNIFORM;
+    settings.das_ms = das_ms_;
+    settings.arr_ms = arr_ms_;
+    std::random_device device;
+    settings.seed_part = (std::uint64_t(device()) << 32) | device();
+
+    if(not versus_thread_.start(settings))
+    {
+        ui->statusBar->showMessage(QString::fromStdString(versus_thread_.error()));
+        return;
+    }
+    versus_ = true;
+    versus_over_ = false;
+    render_versus_snapshot();
+
+    time_played_timer.start(1000);
+
+    ui->startPushButton->setDisabled(true);
+    ui->versusPushButton->setDisabled(true);
+    ui->playernameLineEdit->setDisabled(true);
+    ui->bagCheckBox->setDisabled(true);
+    ui->puzzleCheckBox->setDisabled(true);
+    ui->dasSpinBox->setDisabled(true);
+    ui->arrSpinBox->setDisabled(true);
+    ui->localportSpinBox->setDisabled(true);
+    ui->peerportSpinBox->setDisabled(true);
+    ui->latencySpinBox->setDisabled(true);
+    ui->lossSpinBox->setDisabled(true);
+
+    grabKeyboard();
+}
+
+void MainWindow::on_puzzleCheckBox_toggled(bool checked)
+{
+    solver_.cancel();
+    solver_.wait();
+    puzzle_timer_.stop();
+    solution_timer_.stop();
+    ui->solvePushButton->setText("Solve");
+    ui->solvePushButton->setEnabled(checked);
+    set_puzzle_editable(checked);
+
+    //Games and replays can't be started while the puzzle is on the board
+    bool difficulty = ui->comboBox->currentIndex() != 0;
+    ui->startPushButton->setEnabled(not checked && difficulty);
+    ui->versusPushButton->setEnabled(not checked && difficulty);
+    ui->openreplayPushButton->setEnabled(not checked);
+    replay_reader_.close();
+    ui->replaySlider->setEnabled(false);
+
+    if(checked)
+    {
+        show_puzzle();
+    }
+    else
+    {
+        clear_scene();
+        ui->puzzlestatusLabel->clear();
+    }
+}
+
+void MainWindow::on_importpuzzlePushButton_clicked()
+{
+    QString filename = QFileDialog::getOpenFileName(this, "Import puzzle", "",
+                                                    "Puzzles (*.txt)");
+    if(filename.isEmpty())
+    {
+        return;
+    }
+
+    std::ifstream file(filename.toStdString());
+    if(not file)
+    {
+        ui->statusBar->showMessage("Could not read " + filename);
+        return;
+    }
+    std::stringstream text;
+    text << file.rdbuf();
+
+    if(not puzzle_.parse(text.str()))
+    {
+        ui->statusBar->showMessage(QString::fromStdString(puzzle_.error()));
+        return;
+    }
+
+    //The cells are edited where they are drawn, which is where they land
+    puzzle_.settle();
+    ui->piecesLineEdit->setText(QString::fromStdString(puzzle_.pieces_text()));
+    ui->puzzlerowsSpinBox->setValue(puzzle_.rows());
+    ui->statusBar->clearMessage();
+    show_puzzle();
+}
+
+void MainWindow::on_piecesLineEdit_textEdited(const QString& text)
+{
+    if(not puzzle_.set_pieces(text.toStdString()))
+    {
+        ui->statusBar->showMessage(QString("The tetrominos are the letters ")
+                                   + Board::TETROMINO_LETTERS);
+        return;
+    }
+    ui->statusBar->clearMessage();
+    solution_timer_.stop();
+    show_puzzle();
+}
+
+void MainWindow::on_puzzlerowsSpinBox_valueChanged(int value)
+{
+    puzzle_.set_rows(value);
+    if(ui->puzzleCheckBox->isChecked())
+    {
+        solution_timer_.stop();
+        show_puzzle();
+    }
+}
+
+void MainWindow::on_solvePushButton_clicked()
+{
+    //The progress timer notices when the cancelled search has ended
+    if(solver_.status() == PuzzleSolver::RUNNING)
+    {
+        solver_.cancel();
+        return;
+    }
+
+    solution_timer_.stop();
+    show_puzzle();
+
+    PuzzleSolver::Settings settings;
+    settings.threads = qMax(1u, std::thread::hardware_concurrency());
+    if(not solver_.start(puzzle_, settings))
+    {
+        ui->puzzlestatusLabel->setText(QString::fromStdString(solver_.error()));
+        return;
+    }
+
+    set_puzzle_editable(false);
+    ui->solvePushButton->setText("Cancel");
+    solve_clock_.start();
+    puzzle_timer_.start(100);
+}
+
+void MainWindow::update_puzzle_progress()
+{
+    PuzzleSolver::Progress progress = solver_.progress();
+    if(solver_.status() == PuzzleSolver::RUNNING)
+    {
+        ui->puzzlestatusLabel->setText(QString::number(progress.nodes) + " boards, deepest "
+                                       + QString::number(progress.deepest) + "/"
+                                       + QString::number(progress.pieces) + ", memo "
+                                       + QString::number(progress.memo_size));
+        return;
+    }
+
+    puzzle_timer_.stop();
+    solver_.wait();
+    set_puzzle_editable(true);
+    ui->solvePushButton->setText("Solve");
+
+    QString stats_text = QString::number(progress.nodes) + " boards searched in "
+            + QString::number(solve_clock_.elapsed() / 1000.0, 'f', 2) + " s, pruned "
+            + QString::number(progress.pruned) + ", duplicates "
+            + QString::number(progress.duplicates) + ", memo hits "
+            + QString::number(progress.memo_hits);
+    ui->statusBar->showMessage(stats_text);
+
+    switch(solver_.status())
+    {
+    case PuzzleSolver::SOLVED:
+        //The solution is placed on the puzzle one tetromino at a time
+        ui->puzzlestatusLabel->setText("Solved with "
+                                       + QString::number(solver_.solution().size())
+                                       + " tetrominos");
+        solution_board_ = puzzle_.board();
+        solution_step_ = 0;
+        solution_timer_.start(500);
+        break;
+    case PuzzleSolver::NO_SOLUTION:
+        ui->puzzlestatusLabel->setText("No solution fills "
+                                       + QString::number(puzzle_.target_rows()) + " rows");
+        break;
+    default:
+        ui->puzzlestatusLabel->setText("Cancelled");
+        break;
+    }
+}
+
+void MainWindow::show_solution_step()
 {
-    if(event->key() == Qt::Key_Left)
+    const std::vector<Board::Tetromino>& solution = solver_.solution();
+    if(solution_step_ >= solution.size())
     {
-        on_leftPushButton_clicked();
+        solution_timer_.stop();
+        return;
     }
 
-    if(event->key() == Qt::Key_Right)
+    //The tetromino is shown where it stops and the gravity ticks once,
+    //like when the game creates the next one
+    solution_board_.create_tetromino(puzzle_.pieces().at(solution_step_));
+    solution_board_.set_current(solution.at(solution_step_));
+    solution_board_.drop_all();
+    solution_step_ += 1;
+    update_scene(solution_board_);
+    ui->blocksnumberLabel->setText(QString::number(solution_step_));
+}
+
+bool MainWindow::eventFilter(QObject *watched, QEvent *event)
+{
+    if(watched != ui->graphicsView->viewport() ||
+       event->type() != QEvent::MouseButtonPress ||
+       not ui->puzzleCheckBox->isChecked() ||
+       solver_.status() == PuzzleSolver::RUNNING)
     {
-        on_rightPushButton_clicked();
+        return QMainWindow::eventFilter(watched, event);
     }
 
-    //Works differently to holding the downPushButton, because
-    //the autorepeat function of keyboards was causing issues
-    //with blocks not falling as they should.
-    if(event->key() == Qt::Key_Down)
+    QMouseEvent* mouse = static_cast<QMouseEvent*>(event);
+    QPointF point = ui->graphicsView->mapToScene(mouse->pos());
+    if(point.x() < 0 || point.y() < 0 ||
+       point.x() >= BORDER_RIGHT || point.y() >= BORDER_DOWN)
     {
-        move_block(tetrominos.back(), "DOWN");
+        return true;
     }
 
-    if(event->key() == Qt::Key_Space)
+    //A cell that is added in the air falls on the cells below it, like
+    //everything else on the board
+    int x = point.x() / SQUARE_SIDE;
+    int y = point.y() / SQUARE_SIDE;
+    puzzle_.set_cell(x, y, not puzzle_.cell(x, y));
+    puzzle_.settle();
+    solution_timer_.stop();
+    show_puzzle();
+    return true;
+}
+
+void MainWindow::keyPressEvent(QKeyEvent *event)
+{
+    //Autorepeat of the keyboard is ignored, holding a key is tracked
+    //from the press and release events and repeated by the game thread
+    Game::Input input = input_for_key(event->key());
+    if(input == Game::NUMBER_OF_INPUTS || event->isAutoRepeat())
+    {
+        return;
+    }
+
+    send_input(input, true);
+}
+
+void MainWindow::keyReleaseEvent(QKeyEvent *event)
+{
+    Game::Input input = input_for_key(event->key());
+    if(input == Game::NUMBER_OF_INPUTS || event->isAutoRepeat())
     {
-        on_flipPushButton_clicked();
+        return;
     }
 
-    if(event->key() == Qt::Key_Control)
+    send_input(input, false);
+}
+
+void MainWindow::changeEvent(QEvent *event)
+{
+    QMainWindow::changeEvent(event);
+    if(event->type() == QEvent::WindowStateChange ||
+       event->type() == QEvent::ActivationChange)
     {
-        on_dropPushButton_clicked();
+        update_paused();
     }
+}
 
+void MainWindow::hideEvent(QHideEvent *event)
+{
+    QMainWindow::hideEvent(event);
+    update_paused();
+}
+
+void MainWindow::showEvent(QShowEvent *event)
+{
+    QMainWindow::showEvent(event);
+    update_paused();
+}
 
+void MainWindow::update_paused()
+{
+    bool paused = isMinimized() || not isVisible() || not isActiveWindow();
+    if(paused == paused_ || not game_thread_.is_running())
+    {
+        return;
+    }
+    paused_ = paused;
+    game_thread_.set_paused(paused);
+
+    if(paused)
+    {
+        //Nothing ticks while paused, the time played continues from the
+        //same fraction of a second
+        time_played_remaining_ms_ = qMax(0, time_played_timer.remainingTime());
+        time_played_timer.stop();
+        releaseKeyboard();
+        ui->statusBar->showMessage("Paused");
+    }
+    else
+    {
+        time_played_timer.start(time_played_remaining_ms_);
+        grabKeyboard();
+        ui->statusBar->clearMessage();
+    }
 }
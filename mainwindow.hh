@@ -12,12 +12,24 @@
 #ifndef MAINWINDOW_HH
 #define MAINWINDOW_HH
 
+#include "boardrenderer.hh"
+#include "gamelog.hh"
+#include "gamethread.hh"
+#include "memorytracker.hh"
+#include "puzzle.hh"
+#include "puzzlesolver.hh"
+#include "replay.hh"
+#include "versusthread.hh"
 #include <QMainWindow>
+#include <QElapsedTimer>
 #include <QGraphicsScene>
 #include <QGraphicsRectItem>
 #include <QTimer>
+#include <QImage>
 #include <QKeyEvent>
-#include <random>
+#include <QHideEvent>
+#include <QShowEvent>
+#include <atomic>
 #include <fstream>
 
 namespace Ui {
@@ -33,8 +45,6 @@ public:
     ~MainWindow();
 
 private slots:
-    void on_downPushButton_clicked();
-
     void on_leftPushButton_clicked();
 
     void on_rightPushButton_clicked();
@@ -53,8 +63,73 @@ private slots:
 
     void on_flipPushButton_clicked();
 
+    void on_dasSpinBox_valueChanged(int value);
+
+    void on_arrSpinBox_valueChanged(int value);
+
+    void on_openreplayPushButton_clicked();
+
+    void on_replaySlider_valueChanged(int value);
+
+    void on_versusPushButton_clicked();
+
+    void on_memorydumpPushButton_clicked();
+
+    void on_puzzleCheckBox_toggled(bool checked);
+
+    void on_importpuzzlePushButton_clicked();
+
+    void on_piecesLineEdit_textEdited(const QString& text);
+
+    void on_puzzlerowsSpinBox_valueChanged(int value);
+
+    void on_solvePushButton_clicked();
+
     void keyPressEvent(QKeyEvent *event);
 
+    void keyReleaseEvent(QKeyEvent *event);
+
+    void changeEvent(QEvent *event);
+
+    void hideEvent(QHideEvent *event);
+
+    void showEvent(QShowEvent *event);
+
+    /**
+     * @brief eventFilter Clicking a cell of the board fills or empties it
+     *        while a puzzle is being edited
+     */
+    bool eventFilter(QObject *watched, QEvent *event);
+
+    /**
+     * @brief render_snapshot Draws the latest snapshot of the game thread,
+     *        if the game has changed since the last one
+     */
+    void render_snapshot();
+
+    /**
+     * @brief update_memory_panel Shows the memory used by each part of the
+     *        program and how fast it is allocated, every second
+     */
+    void update_memory_panel();
+
+    /**
+     * @brief render_versus_snapshot Draws the latest snapshot of the versus
+     *        thread, both the own board and the opponent's
+     */
+    void render_versus_snapshot();
+
+    /**
+     * @brief update_puzzle_progress Shows how far the solver has searched,
+     *        and the result once it has finished
+     */
+    void update_puzzle_progress();
+
+    /**
+     * @brief show_solution_step Places the next tetromino of the solution
+     */
+    void show_solution_step();
+
 private:
     Ui::MainWindow *ui;
 
@@ -68,11 +143,6 @@ private:
     const int BORDER_RIGHT = 240; // 680; (in moving circle)
     const int MIDDLE_X = 120;
 
-    //Constants defining max speed of blocks and how fast it changes
-    //as the game goes on
-    const int MAXIMUM_SPEED = 100;
-    const float SPEED_CHANGE_RATE = 0.95;
-
     // Size of a tetromino component
     const int SQUARE_SIDE = 20;
     // Number of horizontal cells (places for tetromino components)
@@ -99,10 +169,6 @@ private:
     // but most probably you need a constant value for NUMBER_OF_TETROMINOS.
 
 
-    // For randomly selecting the next dropping tetromino
-    std::default_random_engine randomEng;
-    std::uniform_int_distribution<int> distr;
-
     /**
      * @brief add_block Adds a single square to the coordinates
      * @param x coordinate
@@ -113,61 +179,61 @@ private:
     QGraphicsRectItem* add_block(int x, int y, QColor color);
 
     /**
-     * @brief move_block Moves shape one SQUARE_SIZE in specified direction
-     * @param shape pointer to shape that is wanted to move
-     * @param dir direction to move the block in(string, e.g. "DOWN")
+     * @brief update_scene Creates squares for new tetrominos, moves the
+     *        squares of the old ones to where they are on the board and
+     *        removes squares of tetrominos that are no longer on the board
+     * @param board to draw
      */
-    void move_block(std::vector<QGraphicsRectItem*> shape, std::string dir);
+    void update_scene(const Board& board);
 
     /**
-     * @brief drop_all Tries to move all shapes down one SQUARE_SIZE
+     * @brief clear_scene Removes the squares of all tetrominos
      */
-    void drop_all();
+    void clear_scene();
 
     /**
-     * @brief new_location Creates a QPoint from given block and direction to move in
-     * @param block whose cordinates this function inspects
-     * @param dir direction which to create the point in
-     * @return the created QPoint
+     * @brief show_replay_frame Sets the board to the frame of the opened
+     *        replay and draws it
+     * @param frame to show
      */
-    QPoint new_location(QGraphicsRectItem* block, std::string dir);
+    void show_replay_frame(quint64 frame);
 
     /**
-     * @brief create_random_tetromino Creates a tetromino whose shape is based on a random value
+     * @brief show_next Shows the upcoming tetrominos in the next label
+     * @param preview kinds of the tetrominos, the first one comes next
      */
-    void create_random_tetromino();
+    void show_next(const std::array<std::uint8_t, PieceGenerator::PREVIEW_SIZE>& preview);
 
     /**
-     * @brief block_can_move Checks if a block can move to the specified point
-     *                       (point is within game bounds and not occupied)
-     * @param point to check
-     * @return bool of whether moving is possible or not
+     * @brief show_puzzle Draws the board of the puzzle and tells how many
+     *        rows are filled with how many tetrominos
      */
-    bool block_can_move(QPoint point);
+    void show_puzzle();
 
     /**
-     * @brief drop_current drops the active tetromino as far down as it can go
+     * @brief set_puzzle_editable Enables or disables changing the puzzle,
+     *        it can't be changed while it is being solved
      */
-    void drop_current();
+    void set_puzzle_editable(bool editable);
 
     /**
-     * @brief shape_can_move Checks if the whole shape can move in the specified direction
-     * @param shape pointer to shape
-     * @param dir direction to check as a string, e.g. "DOWN"
-     * @return bool of whether the shape can move or not
+     * @brief game_over Stops the timers, disables most of the UI,
+     * allows player to enter hiscore
      */
-    bool shape_can_move(std::vector<QGraphicsRectItem*> shape, std::string dir);
+    void game_over();
 
     /**
-     * @brief flip_shape mirrors the active tetromino vertically
+     * @brief versus_game_over Shows who won the versus game and the
+     *        statistics of the rollbacks, disables most of the UI
+     * @param snapshot of the finished game
      */
-    void flip_shape();
+    void versus_game_over(const VersusThread::Snapshot& snapshot);
 
     /**
-     * @brief game_over Stops the timers, disables most of the UI,
-     * allows player to enter hiscore
+     * @brief update_paused Pauses the game when the window is minimized,
+     *        hidden or loses the focus and resumes it when it is back
      */
-    void game_over();
+    void update_paused();
 
     /**
      * @brief readhiscore Reads hiscores from file
@@ -185,34 +251,103 @@ private:
      */
     void tick_time();
 
+    /**
+     * @brief input_for_key Maps a keyboard key to the game input
+     * @param key Qt key code
+     * @return the input, or NUMBER_OF_INPUTS if the key is not used
+     */
+    Game::Input input_for_key(int key) const;
+
+    /**
+     * @brief send_input Passes an input of the player to the game that is
+     *        running, the single player game or the versus game
+     * @param input that was pressed or released
+     * @param pressed true for a press, false for a release
+     */
+    void send_input(Game::Input input, bool pressed);
+
     /**
      * @brief set_difficulty Sets how fast the blocks fall in the beginning of the game
      * @param diff difficulty level 1-4
      */
     void set_difficulty(int diff);
 
-    // Vector containing all the tetrominos on the board
+    // The game runs on its own thread, the window only sends it the inputs
+    // and draws its snapshots
+    GameThread game_thread_;
+
+    // A versus game against another program runs on a thread of its own,
+    // only one of the two threads is running at a time
+    VersusThread versus_thread_;
+    bool versus_ = false;
+    bool versus_over_ = false;
+
+    // The opponent's board is drawn to an image that is shown at half size
+    BoardRenderer opponent_renderer_;
+    QImage opponent_image_ = BoardRenderer::create_image();
+
+    // Vector containing the squares drawn for each tetromino on the board,
+    // in the same order as the tetrominos of the drawn board
     std::vector<std::vector<QGraphicsRectItem*>> tetrominos;
 
-    // Vector of colors for the tetrominos, used in create_random_tetromino
-    std::vector<QColor> colors = {QColor("cyan"), QColor("magenta"), QColor("red"),
-                          QColor("yellow"), QColor("darkCyan"), QColor("darkMagenta"),
-                          QColor("green"), QColor("darkGreen"), QColor("red"),
-                          QColor("blue")};
+    // Vector of colors for the tetrominos, used in update_scene
+    std::vector<QColor> colors = BoardRenderer::colors();
 
 
     // More constants, attibutes, and methods
 
-    //Timers for making the blocks fall and recording time played
-    QTimer gravity_timer;
+    //Timer for recording time played
     QTimer time_played_timer;
 
+    //The memory panel compares the latest counts to the ones of a second
+    //earlier, the same counts are written to the dump file
+    QTimer memory_timer_;
+    QElapsedTimer memory_clock_;
+    MemoryTracker::Snapshot memory_previous_;
+    MemoryTracker::Snapshot memory_latest_;
+    double memory_seconds_ = 0;
+
+    //Set when drawing a snapshot has been queued and not yet done, so that
+    //snapshots published in a burst are drawn only once
+    std::atomic<bool> render_queued_{false};
+    std::atomic<bool> versus_render_queued_{false};
+
+    bool paused_ = false;
+    //What was left of the second of time_played_timer when it was paused
+    int time_played_remaining_ms_ = 0;
+
+    int das_ms_ = Game::Settings().das_ms;
+    int arr_ms_ = Game::Settings().arr_ms;
+
     int time_played_sec_ = 0;
     int time_played_min_ = 0;
 
     int score_ = 0;
     int timerinterval_ = 1000;
 
+    //The games of the session are collected to the same block of the game
+    //log, which is written when the window is closed
+    GameLogWriter game_log_;
+
+    //Difficulty level and start time of the game for the game log
+    int difficulty_ = 0;
+    qint64 game_start_time_ms_ = 0;
+
+    //Puzzle that is being edited and solved, the solution is shown one
+    //tetromino at a time on a board of its own
+    Puzzle puzzle_;
+    PuzzleSolver solver_;
+    QTimer puzzle_timer_;
+    QTimer solution_timer_;
+    QElapsedTimer solve_clock_;
+    Board solution_board_;
+    std::size_t solution_step_ = 0;
+
+    //Replay that is being viewed and the position in it
+    ReplayReader replay_reader_;
+    ReplayReader::Cursor replay_cursor_;
+    Board replay_board_;
+
 };
 
 #endif // MAINWINDOW_HH
@@ -0,0 +1,268 @@
+/* Tetris project: memorytracker.cpp
+ *
+ * Memory tracker file, counts the memory of each part of the program
+ *
+ * Program author/editor:
+ * Name: Rasmus Kivinen
+ * Student number: 285870
+ * UserID: kivinenr
+ * E-Mail: rasmus.kivinen@tuni.fi
+ * */
+
+#include "memorytracker.hh"
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <new>
+#include <sstream>
+
+namespace
+{
+struct Counters
+{
+    std::atomic<std::int64_t> live_bytes{0};
+    std::atomic<std::int64_t> peak_bytes{0};
+    std::atomic<std::uint64_t> allocations{0};
+    std::atomic<std::uint64_t> frees{0};
+    std::atomic<std::uint64_t> allocated_bytes{0};
+};
+
+// Zero before any constructor runs, so allocations made while other
+// globals are being constructed are counted too
+Counters counters[MemoryTracker::NUMBER_OF_SUBSYSTEMS];
+
+thread_local MemoryTracker::Subsystem current_subsystem = MemoryTracker::OTHER;
+
+std::string bytes_text(double bytes)
+{
+    const char* units[] = {"B", "KB", "MB", "GB"};
+    int unit = 0;
+    while(bytes >= 1024 && unit < 3)
+    {
+        bytes /= 1024;
+        unit += 1;
+    }
+    std::ostringstream text;
+    text << std::fixed << std::setprecision(unit == 0 ? 0 : 1) << bytes
+         << " " << units[unit];
+    return text.str();
+}
+
+#ifdef TETRIS_MEMORY_TRACKING
+// Every allocation starts with a header telling its size and the part it
+// was counted for, padded so the memory after it stays aligned
+struct Header
+{
+    std::size_t size;
+    MemoryTracker::Subsystem subsystem;
+};
+
+const std::size_t HEADER_SIZE = (sizeof(Header) + alignof(std::max_align_t) - 1)
+        / alignof(std::max_align_t) * alignof(std::max_align_t);
+
+void* tracked_allocate(std::size_t size)
+{
+    void* memory = std::malloc(HEADER_SIZE + size);
+    if(memory == nullptr)
+    {
+        return nullptr;
+    }
+
+    Header* header = static_cast<Header*>(memory);
+    header->size = size;
+    header->subsystem = current_subsystem;
+
+    Counters& part = counters[header->subsystem];
+    part.allocations.fetch_add(1, std::memory_order_relaxed);
+    part.allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+    std::int64_t live = part.live_bytes.fetch_add(size, std::memory_order_relaxed) + size;
+    std::int64_t peak = part.peak_bytes.load(std::memory_order_relaxed);
+    while(live > peak && not part.peak_bytes.compare_exchange_weak(
+              peak, live, std::memory_order_relaxed))
+    {
+    }
+
+    return static_cast<char*>(memory) + HEADER_SIZE;
+}
+
+void tracked_free(void* pointer)
+{
+    if(pointer == nullptr)
+    {
+        return;
+    }
+
+    Header* header = reinterpret_cast<Header*>(static_cast<char*>(pointer) - HEADER_SIZE);
+    Counters& part = counters[header->subsystem];
+    part.frees.fetch_add(1, std::memory_order_relaxed);
+    part.live_bytes.fetch_sub(header->size, std::memory_order_relaxed);
+    std::free(header);
+}
+
+void* tracked_new(std::size_t size)
+{
+    void* pointer = tracked_allocate(size);
+    if(pointer == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return pointer;
+}
+#endif
+}
+
+#ifdef TETRIS_MEMORY_TRACKING
+void* operator new(std::size_t size)
+{
+    return tracked_new(size);
+}
+
+void* operator new[](std::size_t size)
+{
+    return tracked_new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    return tracked_allocate(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+    return tracked_allocate(size);
+}
+
+void operator delete(void* pointer) noexcept
+{
+    tracked_free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept
+{
+    tracked_free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept
+{
+    tracked_free(pointer);
+}
+
+void operator delete[](void* pointer, std::size_t) noexcept
+{
+    tracked_free(pointer);
+}
+
+void operator delete(void* pointer, const std::nothrow_t&) noexcept
+{
+    tracked_free(pointer);
+}
+
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept
+{
+    tracked_free(pointer);
+}
+#endif
+
+bool MemoryTracker::enabled()
+{
+#ifdef TETRIS_MEMORY_TRACKING
+    return true;
+#else
+    return false;
+#endif
+}
+
+std::string MemoryTracker::subsystem_name(Subsystem subsystem)
+{
+    switch(subsystem)
+    {
+    case GAME_STATE:
+        return "game state";
+    case RENDERING:
+        return "rendering";
+    case PERSISTENCE:
+        return "persistence";
+    default:
+        return "other";
+    }
+}
+
+MemoryTracker::Subsystem MemoryTracker::current()
+{
+    return current_subsystem;
+}
+
+MemoryTracker::Snapshot MemoryTracker::snapshot()
+{
+    Snapshot result;
+    for(int i = 0; i < NUMBER_OF_SUBSYSTEMS; i++)
+    {
+        result.at(i).live_bytes = counters[i].live_bytes.load(std::memory_order_relaxed);
+        result.at(i).peak_bytes = counters[i].peak_bytes.load(std::memory_order_relaxed);
+        result.at(i).allocations = counters[i].allocations.load(std::memory_order_relaxed);
+        result.at(i).frees = counters[i].frees.load(std::memory_order_relaxed);
+        result.at(i).allocated_bytes =
+                counters[i].allocated_bytes.load(std::memory_order_relaxed);
+    }
+    return result;
+}
+
+std::string MemoryTracker::report(const Snapshot& now, const Snapshot& before,
+                                  double seconds)
+{
+    std::ostringstream text;
+    text << std::left << std::setw(13) << "" << std::right
+         << std::setw(10) << "live" << std::setw(10) << "peak"
+         << std::setw(12) << "allocs" << std::setw(10) << "allocs/s"
+         << std::setw(12) << "bytes/s" << "\n";
+
+    for(int i = 0; i < NUMBER_OF_SUBSYSTEMS; i++)
+    {
+        const Stats& stats = now.at(i);
+        double rate = 0;
+        double byte_rate = 0;
+        if(seconds > 0)
+        {
+            rate = (stats.allocations - before.at(i).allocations) / seconds;
+            byte_rate = (stats.allocated_bytes - before.at(i).allocated_bytes) / seconds;
+        }
+
+        text << std::left << std::setw(13) << subsystem_name(Subsystem(i)) << std::right
+             << std::setw(10) << bytes_text(stats.live_bytes)
+             << std::setw(10) << bytes_text(stats.peak_bytes)
+             << std::setw(12) << stats.allocations
+             << std::setw(10) << std::fixed << std::setprecision(0) << rate
+             << std::setw(12) << bytes_text(byte_rate) << "\n";
+    }
+    return text.str();
+}
+
+bool MemoryTracker::write_dump(const std::string& filename, const Snapshot& now,
+                               const Snapshot& before, double seconds)
+{
+    std::ofstream file(filename, std::ofstream::app);
+    if(not file)
+    {
+        return false;
+    }
+
+    std::time_t time = std::time(nullptr);
+    char date[32];
+    std::strftime(date, sizeof(date), "%Y-%m-%d %H:%M:%S", std::localtime(&time));
+    file << date << "\n" << report(now, before, seconds) << "\n";
+    return bool(file);
+}
+
+MemoryScope::MemoryScope(MemoryTracker::Subsystem subsystem):
+    previous_(current_subsystem)
+{
+    current_subsystem = subsystem;
+}
+
+MemoryScope::~MemoryScope()
+{
+    current_subsystem = previous_;
+}
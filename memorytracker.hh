@@ -0,0 +1,109 @@
+/* Tetris project: memorytracker.hh
+ *
+ * Header file for the memory tracker, counts the memory used by each
+ * part of the program. Code that allocates for a part marks it with a
+ * MemoryScope, and every allocation made inside the scope on the same
+ * thread is counted for that part, including the ones made by Qt and
+ * the standard library. Memory is counted for the part that allocated
+ * it, even if it is freed somewhere else.
+ *
+ * Counting replaces the global operator new and delete, so it is only
+ * compiled in with DEFINES += TETRIS_MEMORY_TRACKING. Without it the
+ * scopes cost almost nothing and all the counts stay zero.
+ *
+ * Program author/editor:
+ * Name: Rasmus Kivinen
+ * Student number: 285870
+ * UserID: kivinenr
+ * E-Mail: rasmus.kivinen@tuni.fi
+ * */
+
+#ifndef MEMORYTRACKER_HH
+#define MEMORYTRACKER_HH
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+namespace MemoryTracker
+{
+// Parts of the program memory is counted for. OTHER is everything
+// outside the scopes, e.g. Qt drawing the window.
+enum Subsystem {OTHER,
+                GAME_STATE,
+                RENDERING,
+                PERSISTENCE,
+                NUMBER_OF_SUBSYSTEMS};
+
+struct Stats
+{
+    // Bytes allocated and not yet freed, and the most there has been
+    std::int64_t live_bytes = 0;
+    std::int64_t peak_bytes = 0;
+    // Totals since the program started
+    std::uint64_t allocations = 0;
+    std::uint64_t frees = 0;
+    std::uint64_t allocated_bytes = 0;
+};
+
+typedef std::array<Stats, NUMBER_OF_SUBSYSTEMS> Snapshot;
+
+/**
+ * @brief enabled Whether the counting was compiled in
+ */
+bool enabled();
+
+/**
+ * @brief subsystem_name Name of the part, e.g. "rendering"
+ */
+std::string subsystem_name(Subsystem subsystem);
+
+/**
+ * @brief current The part the allocations of this thread are counted for
+ */
+Subsystem current();
+
+/**
+ * @brief snapshot Reads the counts of all the parts
+ */
+Snapshot snapshot();
+
+/**
+ * @brief report Table of the counts with a row for each part. The rates
+ *        are the allocations and bytes per second since the earlier
+ *        snapshot.
+ * @param now latest snapshot
+ * @param before earlier snapshot
+ * @param seconds between the snapshots
+ * @return the table as text
+ */
+std::string report(const Snapshot& now, const Snapshot& before, double seconds);
+
+/**
+ * @brief write_dump Adds the report to the end of a file with the time
+ *        it was written, so the growth can be followed over a session
+ * @return false if the file couldn't be written
+ */
+bool write_dump(const std::string& filename, const Snapshot& now,
+                const Snapshot& before, double seconds);
+}
+
+class MemoryScope
+{
+public:
+    /**
+     * @brief MemoryScope Counts the allocations of this thread for the
+     *        part until the scope ends, then goes back to the earlier part
+     * @param subsystem to count for
+     */
+    explicit MemoryScope(MemoryTracker::Subsystem subsystem);
+    ~MemoryScope();
+
+    MemoryScope(const MemoryScope&) = delete;
+    MemoryScope& operator=(const MemoryScope&) = delete;
+
+private:
+    MemoryTracker::Subsystem previous_;
+};
+
+#endif // MEMORYTRACKER_HH
@@ -0,0 +1,134 @@
+/* Tetris project: piecegenerator.cpp
+ *
+ * Piece generator file, computes the kinds of the new tetrominos
+ *
+ * Program author/editor:
+ * Name: Rasmus Kivinen
+ * Student number: 285870
+ * UserID: kivinenr
+ * E-Mail: rasmus.kivinen@tuni.fi
+ * */
+
+#include "piecegenerator.hh"
+#include "board.hh"
+#include <utility>
+
+namespace
+{
+// Multipliers and key increments of Philox4x32 (Salmon et al. 2011)
+const std::uint32_t PHILOX_M0 = 0xD2511F53;
+const std::uint32_t PHILOX_M1 = 0xCD9E8D57;
+const std::uint32_t PHILOX_W0 = 0x9E3779B9;
+const std::uint32_t PHILOX_W1 = 0xBB67AE85;
+const int PHILOX_ROUNDS = 10;
+
+/**
+ * @brief below Maps a random word to 0 - n-1 with a multiplication,
+ *        which doesn't depend on the standard library like distributions do
+ */
+int below(std::uint32_t word, int n)
+{
+    return (static_cast<std::uint64_t>(word) * n) >> 32;
+}
+}
+
+std::array<std::uint32_t, 4> PieceGenerator::philox(std::array<std::uint32_t, 4> counter,
+                                                    std::array<std::uint32_t, 2> key)
+{
+    for(int round = 0; round < PHILOX_ROUNDS; round++)
+    {
+        std::uint64_t product0 = static_cast<std::uint64_t>(PHILOX_M0) * counter[0];
+        std::uint64_t product1 = static_cast<std::uint64_t>(PHILOX_M1) * counter[2];
+
+        counter = {static_cast<std::uint32_t>(product1 >> 32) ^ counter[1] ^ key[0],
+                   static_cast<std::uint32_t>(product1),
+                   static_cast<std::uint32_t>(product0 >> 32) ^ counter[3] ^ key[1],
+                   static_cast<std::uint32_t>(product0)};
+
+        key[0] += PHILOX_W0;
+        key[1] += PHILOX_W1;
+    }
+    return counter;
+}
+
+PieceGenerator::PieceGenerator(std::uint64_t seed, Mode mode)
+{
+    reset(seed, mode);
+}
+
+void PieceGenerator::reset(std::uint64_t seed, Mode mode)
+{
+    key_ = {static_cast<std::uint32_t>(seed), static_cast<std::uint32_t>(seed >> 32)};
+    mode_ = mode;
+    index_ = 0;
+
+    preview_start_ = 0;
+    for(int i = 0; i < PREVIEW_SIZE; i++)
+    {
+        preview_.at(i) = piece(i);
+    }
+}
+
+int PieceGenerator::piece(std::uint64_t index) const
+{
+    if(mode_ == UNIFORM)
+    {
+        return below(block(DOMAIN_UNIFORM, index, 0)[0], Board::NUMBER_OF_TETROMINOS);
+    }
+
+    //Each bag is shuffled with Fisher-Yates from its own two blocks, so
+    //only the bag of the piece has to be computed
+    std::uint64_t bag = index / Board::NUMBER_OF_TETROMINOS;
+    std::array<std::uint32_t, 4> first = block(DOMAIN_BAG, bag, 0);
+    std::array<std::uint32_t, 4> second = block(DOMAIN_BAG, bag, 1);
+    std::uint32_t words[] = {first[0], first[1], first[2], first[3],
+                             second[0], second[1]};
+
+    std::array<int, Board::NUMBER_OF_TETROMINOS> order;
+    for(int i = 0; i < Board::NUMBER_OF_TETROMINOS; i++)
+    {
+        order.at(i) = i;
+    }
+    for(int i = Board::NUMBER_OF_TETROMINOS - 1; i > 0; i--)
+    {
+        std::swap(order.at(i), order.at(below(words[Board::NUMBER_OF_TETROMINOS - 1 - i],
+                                              i + 1)));
+    }
+    return order.at(index % Board::NUMBER_OF_TETROMINOS);
+}
+
+int PieceGenerator::next()
+{
+    int kind = preview_.at(preview_start_);
+
+    //The piece that becomes the last one of the queue is PREVIEW_SIZE
+    //pieces after the one taken
+    preview_.at(preview_start_) = piece(index_ + PREVIEW_SIZE);
+    preview_start_ = (preview_start_ + 1) % PREVIEW_SIZE;
+    index_ += 1;
+
+    return kind;
+}
+
+int PieceGenerator::preview(int position) const
+{
+    return preview_.at((preview_start_ + position) % PREVIEW_SIZE);
+}
+
+std::uint64_t PieceGenerator::index() const
+{
+    return index_;
+}
+
+PieceGenerator::Mode PieceGenerator::mode() const
+{
+    return mode_;
+}
+
+std::array<std::uint32_t, 4> PieceGenerator::block(Domain domain, std::uint64_t index,
+                                                   std::uint32_t number) const
+{
+    return philox({static_cast<std::uint32_t>(index),
+                   static_cast<std::uint32_t>(index >> 32), number,
+                   static_cast<std::uint32_t>(domain)}, key_);
+}
@@ -0,0 +1,95 @@
+/* Tetris project: piecegenerator.hh
+ *
+ * Header file for the piece generator, chooses the kinds of the new
+ * tetrominos. It uses the counter based Philox4x32-10 generator keyed by
+ * the seed of the game, so piece N is computed directly from the seed and
+ * N without drawing the pieces before it. The sequence is the same on
+ * every platform, and games with different seeds get independent
+ * sequences, no matter how many of them are played at the same time.
+ *
+ * Program author/editor:
+ * Name: Rasmus Kivinen
+ * Student number: 285870
+ * UserID: kivinenr
+ * E-Mail: rasmus.kivinen@tuni.fi
+ * */
+
+#ifndef PIECEGENERATOR_HH
+#define PIECEGENERATOR_HH
+
+#include <array>
+#include <cstdint>
+
+class PieceGenerator
+{
+public:
+    // UNIFORM: every piece is any of the tetrominos with equal chance.
+    // BAG: every 7 pieces contain each tetromino once, in random order.
+    enum Mode {UNIFORM, BAG};
+
+    // Number of upcoming pieces kept ready in the preview queue
+    static const int PREVIEW_SIZE = 5;
+
+    /**
+     * @brief philox Philox4x32-10 block function
+     * @param counter the block to generate
+     * @param key the seed
+     * @return four random 32-bit words
+     */
+    static std::array<std::uint32_t, 4> philox(std::array<std::uint32_t, 4> counter,
+                                               std::array<std::uint32_t, 2> key);
+
+    explicit PieceGenerator(std::uint64_t seed = 0, Mode mode = UNIFORM);
+
+    /**
+     * @brief reset Starts a new sequence from the first piece
+     * @param seed of the game
+     * @param mode of the sequence
+     */
+    void reset(std::uint64_t seed, Mode mode);
+
+    /**
+     * @brief piece Computes the kind of any piece of the sequence
+     * @param index of the piece, the first piece is 0
+     * @return 0 - Board::NUMBER_OF_TETROMINOS-1
+     */
+    int piece(std::uint64_t index) const;
+
+    /**
+     * @brief next Takes the first piece of the preview queue and adds
+     *        a new one to its end
+     * @return kind of the piece
+     */
+    int next();
+
+    /**
+     * @brief preview The upcoming pieces, preview(0) is returned by the next call of next()
+     * @param position 0 - PREVIEW_SIZE-1
+     */
+    int preview(int position) const;
+
+    // Number of pieces taken with next()
+    std::uint64_t index() const;
+
+    Mode mode() const;
+
+private:
+    // Separates the random numbers of the modes from each other
+    enum Domain {DOMAIN_UNIFORM, DOMAIN_BAG};
+
+    /**
+     * @brief block Random words for a domain, index and block number
+     */
+    std::array<std::uint32_t, 4> block(Domain domain, std::uint64_t index,
+                                       std::uint32_t number) const;
+
+    std::array<std::uint32_t, 2> key_;
+    Mode mode_;
+    std::uint64_t index_ = 0;
+
+    // Ring buffer of the upcoming pieces, the first one is at preview_start_
+    std::array<std::uint8_t, PREVIEW_SIZE> preview_;
+    int preview_start_ = 0;
+};
+
+#endif // PIECEGENERATOR_HH
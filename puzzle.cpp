@@ -0,0 +1,322 @@
+/* Tetris project: puzzle.cpp
+ *
+ * Puzzle file, a board and a known tetromino sequence
+ *
+ * Program author/editor:
+ * Name: Rasmus Kivinen
+ * Student number: 285870
+ * UserID: kivinenr
+ * E-Mail: rasmus.kivinen@tuni.fi
+ * */
+
+#include "puzzle.hh"
+#include <algorithm>
+#include <cctype>
+#include <sstream>
+
+namespace
+{
+std::string trimmed(const std::string& line)
+{
+    std::size_t first = line.find_first_not_of(" \t\r");
+    if(first == std::string::npos)
+    {
+        return "";
+    }
+    std::size_t last = line.find_last_not_of(" \t\r");
+    return line.substr(first, last - first + 1);
+}
+}
+
+Puzzle::Puzzle()
+{
+}
+
+void Puzzle::clear()
+{
+    cells_.reset();
+    pieces_.clear();
+    rows_ = 0;
+    error_.clear();
+}
+
+bool Puzzle::parse(const std::string& text)
+{
+    clear();
+
+    std::istringstream input(text);
+    std::string line;
+    std::vector<std::string> grid;
+    int line_number = 0;
+    while(std::getline(input, line))
+    {
+        line_number += 1;
+        line = trimmed(line);
+        bool row = line.size() == std::size_t(Board::COLUMNS) &&
+                line.find_first_not_of(".#") == std::string::npos;
+        if(row)
+        {
+            grid.push_back(line);
+            continue;
+        }
+        if(line.empty() || line.at(0) == '#')
+        {
+            continue;
+        }
+
+        std::istringstream words(line);
+        std::string word;
+        words >> word;
+        if(word == "pieces")
+        {
+            std::string letters;
+            words >> letters;
+            if(not set_pieces(letters))
+            {
+                error_ = "Unknown tetromino on line " + std::to_string(line_number);
+                return false;
+            }
+        }
+        else if(word == "rows")
+        {
+            if(not (words >> rows_) || rows_ < 0 || rows_ > Board::ROWS)
+            {
+                error_ = "Bad number of rows on line " + std::to_string(line_number);
+                return false;
+            }
+        }
+        else
+        {
+            error_ = "Line " + std::to_string(line_number) + " is not a row of "
+                    + std::to_string(Board::COLUMNS) + " cells";
+            return false;
+        }
+    }
+
+    if(grid.size() > std::size_t(Board::ROWS))
+    {
+        error_ = "More rows than the board has";
+        return false;
+    }
+
+    //The last row of the text is the bottom row of the board
+    int top = Board::ROWS - grid.size();
+    for(std::size_t row = 0; row < grid.size(); row++)
+    {
+        for(int x = 0; x < Board::COLUMNS; x++)
+        {
+            set_cell(x, top + row, grid.at(row).at(x) == '#');
+        }
+    }
+    return true;
+}
+
+std::string Puzzle::to_text() const
+{
+    std::string text = "pieces " + pieces_text() + "\n"
+            + "rows " + std::to_string(rows_) + "\n";
+
+    //Empty rows at the top are left out
+    int top = 0;
+    while(top < Board::ROWS)
+    {
+        bool empty = true;
+        for(int x = 0; x < Board::COLUMNS; x++)
+        {
+            empty = empty && not cell(x, top);
+        }
+        if(not empty)
+        {
+            break;
+        }
+        top += 1;
+    }
+
+    for(int y = top; y < Board::ROWS; y++)
+    {
+        for(int x = 0; x < Board::COLUMNS; x++)
+        {
+            text += cell(x, y) ? '#' : '.';
+        }
+        text += "\n";
+    }
+    return text;
+}
+
+const std::string& Puzzle::error() const
+{
+    return error_;
+}
+
+bool Puzzle::cell(int x, int y) const
+{
+    return cells_.test(y * Board::COLUMNS + x);
+}
+
+void Puzzle::set_cell(int x, int y, bool filled)
+{
+    cells_.set(y * Board::COLUMNS + x, filled);
+}
+
+const std::vector<std::uint8_t>& Puzzle::pieces() const
+{
+    return pieces_;
+}
+
+bool Puzzle::set_pieces(const std::string& letters)
+{
+    std::vector<std::uint8_t> pieces;
+    for(char c: letters)
+    {
+        int piece = kind(std::toupper(c));
+        if(piece < 0)
+        {
+            return false;
+        }
+        pieces.push_back(piece);
+    }
+    pieces_ = pieces;
+    return true;
+}
+
+std::string Puzzle::pieces_text() const
+{
+    std::string text;
+    for(auto piece: pieces_)
+    {
+        text += letter(piece);
+    }
+    return text;
+}
+
+void Puzzle::set_rows(int rows)
+{
+    rows_ = rows;
+}
+
+int Puzzle::rows() const
+{
+    return rows_;
+}
+
+int Puzzle::target_rows() const
+{
+    if(rows_ > 0)
+    {
+        return rows_;
+    }
+
+    //The cells fall before the puzzle starts, so the rows are counted
+    //from the board where they have landed
+    Board landed = board();
+    int height = 1;
+    int filled = 0;
+    for(int y = 0; y < Board::ROWS; y++)
+    {
+        for(int x = 0; x < Board::COLUMNS; x++)
+        {
+            if(landed.occupied(x, y) > 0)
+            {
+                height = std::max(height, Board::ROWS - y);
+                filled += 1;
+            }
+        }
+    }
+
+    //The rows that all the given tetrominos fill exactly, if there are such
+    int cells = filled + pieces_.size() * Board::BLOCKS_PER_TETROMINO;
+    if(cells % Board::COLUMNS == 0 && cells / Board::COLUMNS >= height &&
+            cells / Board::COLUMNS <= Board::ROWS)
+    {
+        return cells / Board::COLUMNS;
+    }
+
+    //Otherwise the lowest rows that can be filled with some of them. The
+    //rows have a multiple of four cells, so if the filled cells don't,
+    //no rows can be filled and the solver tells why.
+    if(filled % Board::BLOCKS_PER_TETROMINO != 0)
+    {
+        return height;
+    }
+    int rows = height;
+    while(rows < Board::ROWS &&
+          (rows * Board::COLUMNS - filled) % Board::BLOCKS_PER_TETROMINO != 0)
+    {
+        rows += 1;
+    }
+    return rows;
+}
+
+Board Puzzle::board() const
+{
+    std::vector<Board::Tetromino> shapes;
+    for(int y = Board::ROWS - 1; y >= 0; y--)
+    {
+        for(int x = 0; x < Board::COLUMNS; x++)
+        {
+            if(cell(x, y))
+            {
+                Board::Tetromino shape;
+                shape.kind = CELL_KIND;
+                shape.blocks.fill({std::int8_t(x), std::int8_t(y)});
+                shapes.push_back(shape);
+            }
+        }
+    }
+
+    //Nothing falls more than the height of the board
+    Board board;
+    board.load(shapes);
+    for(int i = 0; i < Board::ROWS; i++)
+    {
+        board.drop_all();
+    }
+    return board;
+}
+
+void Puzzle::settle()
+{
+    Board landed = board();
+    cells_.reset();
+    for(int y = 0; y < Board::ROWS; y++)
+    {
+        for(int x = 0; x < Board::COLUMNS; x++)
+        {
+            set_cell(x, y, landed.occupied(x, y) > 0);
+        }
+    }
+}
+
+bool Puzzle::is_solved(const Board& board, int rows)
+{
+    for(int y = 0; y < Board::ROWS; y++)
+    {
+        bool target = y >= Board::ROWS - rows;
+        for(int x = 0; x < Board::COLUMNS; x++)
+        {
+            if((board.occupied(x, y) > 0) != target)
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+char Puzzle::letter(int kind)
+{
+    return kind >= 0 && kind < Board::NUMBER_OF_TETROMINOS ?
+                Board::TETROMINO_LETTERS[kind] : '#';
+}
+
+int Puzzle::kind(char letter)
+{
+    for(int kind = 0; kind < Board::NUMBER_OF_TETROMINOS; kind++)
+    {
+        if(Board::TETROMINO_LETTERS[kind] == letter)
+        {
+            return kind;
+        }
+    }
+    return -1;
+}
@@ -0,0 +1,129 @@
+/* Tetris project: puzzle.hh
+ *
+ * Header file for the puzzle, a board with some cells already filled
+ * and a known sequence of tetrominos. This game never clears lines, so
+ * instead of clearing the board the puzzle is solved by filling the
+ * given number of bottom rows completely without anything above them,
+ * which is exactly the board a perfect clear would clear.
+ *
+ * Text format, one item per line:
+ *   # comment
+ *   pieces IJLOSTZ    the tetrominos in the order they come
+ *   rows 4            bottom rows to fill, 0 or missing for automatic
+ *   ..##........      rows of the board, '.' is empty and '#' filled.
+ *                     The last row is the bottom of the board, there
+ *                     can be fewer rows than the board has.
+ *
+ * Program author/editor:
+ * Name: Rasmus Kivinen
+ * Student number: 285870
+ * UserID: kivinenr
+ * E-Mail: rasmus.kivinen@tuni.fi
+ * */
+
+#ifndef PUZZLE_HH
+#define PUZZLE_HH
+
+#include "board.hh"
+#include <bitset>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class Puzzle
+{
+public:
+    // Kind of the single cells of the board. A cell is a tetromino whose
+    // four blocks are all in the same place, so the rules of the board
+    // work for it without changes.
+    static const int CELL_KIND = Board::NUMBER_OF_TETROMINOS;
+
+    using Cells = std::bitset<Board::COLUMNS * Board::ROWS>;
+
+    Puzzle();
+
+    /**
+     * @brief clear Empties the board and the tetromino sequence
+     */
+    void clear();
+
+    /**
+     * @brief parse Reads the puzzle from text
+     * @param text in the format above
+     * @return false if the text isn't a puzzle, see error()
+     */
+    bool parse(const std::string& text);
+
+    /**
+     * @brief to_text Writes the puzzle in the format parse reads
+     */
+    std::string to_text() const;
+
+    const std::string& error() const;
+
+    bool cell(int x, int y) const;
+    void set_cell(int x, int y, bool filled);
+
+    const std::vector<std::uint8_t>& pieces() const;
+
+    /**
+     * @brief set_pieces Sets the tetromino sequence from letters, e.g. "IOLJ"
+     * @return false if there is a letter that isn't a tetromino
+     */
+    bool set_pieces(const std::string& letters);
+    std::string pieces_text() const;
+
+    /**
+     * @brief set_rows Sets the number of bottom rows to fill
+     * @param rows to fill, 0 for automatic
+     */
+    void set_rows(int rows);
+    int rows() const;
+
+    /**
+     * @brief target_rows The rows to fill. Automatic is the rows that all
+     *        the tetrominos fill exactly, or if there are none, the lowest
+     *        rows that cover the filled cells and have a multiple of four
+     *        empty cells.
+     */
+    int target_rows() const;
+
+    /**
+     * @brief board The board of the puzzle with each filled cell as a
+     *        tetromino of its own. The cells fall like everything else
+     *        in this game, so the board is returned after they have
+     *        landed.
+     */
+    Board board() const;
+
+    /**
+     * @brief settle Moves the cells to where they land on the board, so
+     *        that the cells are the ones that are drawn
+     */
+    void settle();
+
+    /**
+     * @brief is_solved Checks if the bottom rows are full and everything
+     *        above them is empty
+     */
+    static bool is_solved(const Board& board, int rows);
+
+    /**
+     * @brief letter Letter of the tetromino kind, e.g. 'I'
+     */
+    static char letter(int kind);
+
+    /**
+     * @brief kind Tetromino kind of the letter
+     * @return the kind, or -1 if the letter isn't a tetromino
+     */
+    static int kind(char letter);
+
+private:
+    Cells cells_;
+    std::vector<std::uint8_t> pieces_;
+    int rows_ = 0;
+    std::string error_;
+};
+
+#endif // PUZZLE_HH
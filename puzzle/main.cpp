@@ -0,0 +1,152 @@
+/* Tetris project: puzzle/main.cpp
+ *
+ * Main function of the puzzle solver. Reads a puzzle (see puzzle.hh),
+ * shows the progress every second and prints the placements of the
+ * solution. Usage:
+ *   tetrispuzzle PUZZLE [--threads N] [--memo ENTRIES]
+ *
+ * Program author/editor:
+ * Name: Rasmus Kivinen
+ * Student number: 285870
+ * UserID: kivinenr
+ * E-Mail: rasmus.kivinen@tuni.fi
+ * */
+
+#include "puzzlesolver.hh"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+namespace
+{
+void print_progress(const PuzzleSolver::Progress& progress, double seconds)
+{
+    std::cout << seconds << " s: " << progress.nodes << " boards, deepest "
+              << progress.deepest << "/" << progress.pieces
+              << ", tasks " << progress.tasks_done << "/" << progress.tasks
+              << ", memo " << progress.memo_size << " (" << progress.memo_hits
+              << " hits), pruned " << progress.pruned
+              << ", duplicates " << progress.duplicates << std::endl;
+}
+}
+
+int main(int argc, char *argv[])
+{
+    std::string filename;
+    PuzzleSolver::Settings settings;
+    settings.threads = std::max(1u, std::thread::hardware_concurrency());
+
+    for(int i = 1; i < argc; i++)
+    {
+        std::string option = argv[i];
+        if(option.compare(0, 2, "--") != 0)
+        {
+            filename = option;
+            continue;
+        }
+        if(i + 1 >= argc)
+        {
+            std::cerr << "Missing value for " << option << std::endl;
+            return 1;
+        }
+        std::string value = argv[++i];
+
+        if(option == "--threads")
+        {
+            settings.threads = std::stoi(value);
+        }
+        else if(option == "--memo")
+        {
+            settings.memo_limit = std::stoull(value);
+        }
+        else
+        {
+            std::cerr << "Unknown option " << option << std::endl;
+            return 1;
+        }
+    }
+
+    std::ifstream file(filename);
+    if(not file)
+    {
+        std::cerr << "Could not read " << filename << std::endl;
+        return 1;
+    }
+    std::stringstream text;
+    text << file.rdbuf();
+
+    Puzzle puzzle;
+    if(not puzzle.parse(text.str()))
+    {
+        std::cerr << puzzle.error() << std::endl;
+        return 1;
+    }
+
+    PuzzleSolver solver;
+    auto start = std::chrono::steady_clock::now();
+    if(not solver.start(puzzle, settings))
+    {
+        std::cerr << solver.error() << std::endl;
+        return 1;
+    }
+
+    while(solver.status() == PuzzleSolver::RUNNING)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        if(solver.status() == PuzzleSolver::RUNNING &&
+                int(elapsed.count() * 10) % 10 == 0)
+        {
+            print_progress(solver.progress(), int(elapsed.count()));
+        }
+    }
+    solver.wait();
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    print_progress(solver.progress(), elapsed.count());
+
+    if(solver.status() != PuzzleSolver::SOLVED)
+    {
+        std::cout << "No solution, filling " << puzzle.target_rows()
+                  << " rows is impossible" << std::endl;
+        return 2;
+    }
+
+    //The filled rows with the cells of the puzzle as '#' and each
+    //tetromino as its number in the sequence
+    const std::string NUMBERS = "123456789abcdefghijklmnopqrstuvwxyz";
+    const std::vector<Board::Tetromino>& solution = solver.solution();
+    Board board = puzzle.board();
+    std::vector<std::string> rows(Board::ROWS, std::string(Board::COLUMNS, '.'));
+    for(int y = 0; y < Board::ROWS; y++)
+    {
+        for(int x = 0; x < Board::COLUMNS; x++)
+        {
+            if(board.occupied(x, y) > 0)
+            {
+                rows.at(y).at(x) = '#';
+            }
+        }
+    }
+
+    std::cout << "Solved:";
+    for(std::size_t i = 0; i < solution.size(); i++)
+    {
+        char number = NUMBERS.at(i % NUMBERS.size());
+        std::cout << " " << number << "=" << Puzzle::letter(puzzle.pieces().at(i));
+        for(auto block: solution.at(i).blocks)
+        {
+            rows.at(block.y).at(block.x) = number;
+        }
+    }
+    std::cout << std::endl;
+    for(int y = Board::ROWS - puzzle.target_rows(); y < Board::ROWS; y++)
+    {
+        std::cout << rows.at(y) << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,25 @@
+#-------------------------------------------------
+#
+# Solves a puzzle: fills the bottom rows of
+# a board with a known tetromino sequence
+#
+#-------------------------------------------------
+
+TARGET = tetrispuzzle
+TEMPLATE = app
+
+CONFIG += console c++14 thread
+CONFIG -= app_bundle qt
+
+INCLUDEPATH += ..
+
+SOURCES += \
+        main.cpp \
+        ../board.cpp \
+        ../puzzle.cpp \
+        ../puzzlesolver.cpp
+
+HEADERS += \
+        ../board.hh \
+        ../puzzle.hh \
+        ../puzzlesolver.hh
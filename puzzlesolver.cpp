@@ -0,0 +1,566 @@
+/* Tetris project: puzzlesolver.cpp
+ *
+ * Puzzle solver file, searches the placements that solve a puzzle
+ *
+ * Program author/editor:
+ * Name: Rasmus Kivinen
+ * Student number: 285870
+ * UserID: kivinenr
+ * E-Mail: rasmus.kivinen@tuni.fi
+ * */
+
+#include "puzzlesolver.hh"
+#include <algorithm>
+
+namespace
+{
+// The search is split into at least this many tasks per thread, so the
+// threads that get easy tasks take new ones instead of waiting
+const std::size_t TASKS_PER_THREAD = 8;
+
+// Boards searched between adding the counts to the shared progress
+const std::uint64_t FLUSH_NODES = 1024;
+
+// Places of a falling tetromino, both ways flipped and every cell of its
+// first block
+const std::size_t PLACES = 2 * Board::COLUMNS * Board::ROWS;
+
+std::size_t place_index(const Board::Tetromino& shape, bool flipped)
+{
+    const Board::Block& first = shape.blocks.front();
+    return (flipped ? Board::COLUMNS * Board::ROWS : 0) +
+            first.y * Board::COLUMNS + first.x;
+}
+
+void raise_to(std::atomic<int>& value, int at_least)
+{
+    int current = value.load(std::memory_order_relaxed);
+    while(current < at_least && not value.compare_exchange_weak(current, at_least))
+    {
+    }
+}
+}
+
+bool PuzzleSolver::Key::operator==(const Key& other) const
+{
+    return piece == other.piece && cells == other.cells;
+}
+
+std::size_t PuzzleSolver::KeyHash::operator()(const Key& key) const
+{
+    std::uint64_t hash = key.piece;
+    for(auto word: key.cells)
+    {
+        hash = (hash ^ word) * 0x9e3779b97f4a7c15ULL;
+        hash ^= hash >> 29;
+    }
+    return hash;
+}
+
+PuzzleSolver::PuzzleSolver()
+{
+}
+
+PuzzleSolver::~PuzzleSolver()
+{
+    cancel();
+    wait();
+}
+
+bool PuzzleSolver::start(const Puzzle& puzzle, const Settings& settings)
+{
+    cancel();
+    wait();
+    error_.clear();
+
+    start_ = puzzle.board();
+    rows_ = puzzle.target_rows();
+
+    //Only the tetrominos that fit in the empty cells are used, in order
+    int top = Board::ROWS - rows_;
+    int empty = 0;
+    for(int y = 0; y < Board::ROWS; y++)
+    {
+        for(int x = 0; x < Board::COLUMNS; x++)
+        {
+            bool filled = start_.occupied(x, y) > 0;
+            if(filled && y < top)
+            {
+                error_ = "There are cells above the rows to fill";
+                return false;
+            }
+            empty += y >= top && not filled ? 1 : 0;
+        }
+    }
+    if(empty % Board::BLOCKS_PER_TETROMINO != 0)
+    {
+        error_ = std::to_string(empty) + " empty cells can't be filled with tetrominos";
+        return false;
+    }
+
+    std::size_t needed = empty / Board::BLOCKS_PER_TETROMINO;
+    if(needed > puzzle.pieces().size())
+    {
+        error_ = "Filling the rows needs " + std::to_string(needed) + " tetrominos, "
+                + std::to_string(puzzle.pieces().size()) + " were given";
+        return false;
+    }
+    pieces_.assign(puzzle.pieces().begin(), puzzle.pieces().begin() + needed);
+
+    settings_ = settings;
+    settings_.threads = std::max(1, settings.threads);
+    for(auto& shard: memo_)
+    {
+        shard.keys.clear();
+    }
+    tasks_.clear();
+    next_task_ = 0;
+    nodes_ = 0;
+    pruned_ = 0;
+    duplicates_ = 0;
+    memo_hits_ = 0;
+    memo_size_ = 0;
+    tasks_count_ = 0;
+    tasks_done_ = 0;
+    deepest_ = 0;
+    found_ = false;
+    solution_.clear();
+
+    stop_ = false;
+    cancelled_ = false;
+    status_ = RUNNING;
+    thread_ = std::thread(&PuzzleSolver::run, this);
+    return true;
+}
+
+void PuzzleSolver::cancel()
+{
+    cancelled_ = true;
+    stop_ = true;
+}
+
+void PuzzleSolver::wait()
+{
+    if(thread_.joinable())
+    {
+        thread_.join();
+    }
+}
+
+PuzzleSolver::Status PuzzleSolver::status() const
+{
+    return Status(status_.load());
+}
+
+PuzzleSolver::Progress PuzzleSolver::progress() const
+{
+    Progress progress;
+    progress.nodes = nodes_;
+    progress.pruned = pruned_;
+    progress.duplicates = duplicates_;
+    progress.memo_hits = memo_hits_;
+    progress.memo_size = memo_size_;
+    progress.tasks = tasks_count_;
+    progress.tasks_done = tasks_done_;
+    progress.deepest = deepest_;
+    progress.pieces = pieces_.size();
+    return progress;
+}
+
+const std::string& PuzzleSolver::error() const
+{
+    return error_;
+}
+
+const std::vector<Board::Tetromino>& PuzzleSolver::solution() const
+{
+    return solution_;
+}
+
+void PuzzleSolver::run()
+{
+    //The first levels are searched breadth first until there are enough
+    //tasks for all the threads
+    Worker worker;
+    Board spawned;
+    std::vector<Child> children;
+    std::vector<Task> tasks(1);
+    tasks.front().board = start_;
+    tasks.front().piece = 0;
+
+    while(tasks.size() < settings_.threads * TASKS_PER_THREAD &&
+          tasks.front().piece < pieces_.size() && not stop_)
+    {
+        std::vector<Task> next;
+        for(const Task& task: tasks)
+        {
+            worker.nodes += 1;
+            if(not expand(worker, task.board, task.piece, spawned, children))
+            {
+                continue;
+            }
+            for(const Child& child: children)
+            {
+                Task branch;
+                branch.board = spawned;
+                place(branch.board, child.placement);
+                branch.piece = task.piece + 1;
+                branch.path = task.path;
+                branch.path.push_back(child.placement);
+                next.push_back(branch);
+            }
+        }
+        tasks.swap(next);
+        if(tasks.empty())
+        {
+            break;
+        }
+    }
+    worker.deepest = tasks.empty() ? 0 : tasks.front().piece;
+    flush(worker);
+
+    tasks_ = tasks;
+    tasks_count_ = tasks_.size();
+
+    std::vector<std::thread> threads;
+    for(int i = 0; i < settings_.threads; i++)
+    {
+        threads.push_back(std::thread(&PuzzleSolver::work, this));
+    }
+    for(auto& thread: threads)
+    {
+        thread.join();
+    }
+
+    if(found_)
+    {
+        status_ = SOLVED;
+    }
+    else
+    {
+        status_ = cancelled_ ? CANCELLED : NO_SOLUTION;
+    }
+}
+
+void PuzzleSolver::work()
+{
+    //Every level of the search has its own board and list of children,
+    //so searching doesn't allocate after the first branch
+    Worker worker;
+    std::size_t levels = pieces_.size() + 1;
+    worker.boards.resize(levels);
+    worker.spawned.resize(levels);
+    worker.children.resize(levels);
+    worker.path.reserve(levels);
+
+    while(not stop_)
+    {
+        std::size_t index = next_task_++;
+        if(index >= tasks_.size())
+        {
+            break;
+        }
+
+        const Task& task = tasks_.at(index);
+        worker.boards.front() = task.board;
+        worker.path = task.path;
+        if(search(worker, 0, task.piece))
+        {
+            std::lock_guard<std::mutex> lock(solution_mutex_);
+            if(not found_)
+            {
+                found_ = true;
+                solution_ = worker.path;
+            }
+            stop_ = true;
+        }
+        tasks_done_ += 1;
+        flush(worker);
+    }
+    flush(worker);
+}
+
+bool PuzzleSolver::search(Worker& worker, std::size_t level, std::uint32_t piece)
+{
+    if(stop_)
+    {
+        return false;
+    }
+
+    worker.nodes += 1;
+    worker.deepest = std::max<int>(worker.deepest, piece);
+    if(worker.nodes % FLUSH_NODES == 0)
+    {
+        flush(worker);
+    }
+
+    const Board& board = worker.boards.at(level);
+    if(piece == pieces_.size())
+    {
+        return Puzzle::is_solved(board, rows_);
+    }
+
+    Key key = key_of(board, piece);
+    if(remembered(key))
+    {
+        worker.memo_hits += 1;
+        return false;
+    }
+
+    Board& spawned = worker.spawned.at(level);
+    std::vector<Child>& children = worker.children.at(level);
+    if(expand(worker, board, piece, spawned, children))
+    {
+        for(const Child& child: children)
+        {
+            Board& next = worker.boards.at(level + 1);
+            next = spawned;
+            place(next, child.placement);
+
+            worker.path.push_back(child.placement);
+            if(search(worker, level + 1, piece + 1))
+            {
+                return true;
+            }
+            worker.path.pop_back();
+
+            if(stop_)
+            {
+                return false;
+            }
+        }
+    }
+
+    //Only boards that were searched to the end are remembered, a
+    //cancelled search doesn't prove anything
+    if(not stop_)
+    {
+        remember(key);
+    }
+    return false;
+}
+
+bool PuzzleSolver::expand(Worker& worker, const Board& board, std::uint32_t piece,
+                          Board& spawned, std::vector<Child>& children)
+{
+    children.clear();
+    spawned = board;
+    if(not spawned.create_tetromino(pieces_.at(piece)))
+    {
+        return false;
+    }
+
+    //The places are tried on one board by moving the tetromino there. The
+    //other tetrominos have landed, so the gravity only moves this one.
+    Board& work = worker.scratch;
+    work = spawned;
+    worker.states.clear();
+    worker.reached.assign(PLACES, 0);
+
+    State start = {work.tetrominos().back(), false};
+    worker.reached.at(place_index(start.shape, start.flipped)) = 1;
+    worker.states.push_back(start);
+
+    for(std::size_t i = 0; i < worker.states.size(); i++)
+    {
+        State state = worker.states.at(i);
+
+        //Moving down is the same as a tick of the gravity that doesn't
+        //stop the tetromino, so left, right, flip and the gravity are
+        //all the moves there are
+        bool stopped = false;
+        for(int move = 0; move <= 3; move++)
+        {
+            work.set_current(state.shape);
+            bool moved = false;
+            if(move == 0)
+            {
+                moved = work.move_block(Board::LEFT);
+            }
+            else if(move == 1)
+            {
+                moved = work.move_block(Board::RIGHT);
+            }
+            else if(move == 2)
+            {
+                moved = work.flip_shape();
+            }
+            else
+            {
+                stopped = work.drop_all();
+                moved = not stopped;
+            }
+
+            if(moved)
+            {
+                State next = {work.tetrominos().back(), state.flipped != (move == 2)};
+                std::uint8_t& reached = worker.reached.at(place_index(next.shape,
+                                                                      next.flipped));
+                if(not reached)
+                {
+                    reached = 1;
+                    worker.states.push_back(next);
+                }
+            }
+        }
+
+        //The gravity stopped the tetromino here, the board is the one the
+        //next tetromino is created on
+        if(not stopped)
+        {
+            continue;
+        }
+        work.set_current(state.shape);
+
+        Key key = key_of(work, piece + 1);
+        if(std::any_of(children.begin(), children.end(),
+                       [&key](const Child& child) { return child.key == key; }))
+        {
+            worker.duplicates += 1;
+            continue;
+        }
+        if(not can_be_solved(work))
+        {
+            worker.pruned += 1;
+            continue;
+        }
+
+        int depth = 0;
+        for(auto block: state.shape.blocks)
+        {
+            depth += block.y;
+        }
+        children.push_back({state.shape, depth, key});
+    }
+
+    std::stable_sort(children.begin(), children.end(),
+                     [](const Child& a, const Child& b) { return a.depth > b.depth; });
+    return true;
+}
+
+void PuzzleSolver::place(Board& board, const Board::Tetromino& placement)
+{
+    board.set_current(placement);
+    board.drop_all();
+}
+
+bool PuzzleSolver::can_be_solved(const Board& board) const
+{
+    int top = Board::ROWS - rows_;
+    for(int y = 0; y < top; y++)
+    {
+        for(int x = 0; x < Board::COLUMNS; x++)
+        {
+            if(board.occupied(x, y) > 0)
+            {
+                return false;
+            }
+        }
+    }
+
+    //A tetromino fills four cells of one empty area of the rows to fill,
+    //so every area is filled with whole tetrominos. Tucks and flips can
+    //reach covered cells, so an area doesn't need to be open from above.
+    std::array<bool, Board::COLUMNS * Board::ROWS> counted = {};
+    std::array<int, Board::COLUMNS * Board::ROWS> cells;
+    for(int start = top * Board::COLUMNS; start < Board::COLUMNS * Board::ROWS; start++)
+    {
+        if(counted.at(start) || board.occupied(start % Board::COLUMNS,
+                                                start / Board::COLUMNS) > 0)
+        {
+            continue;
+        }
+
+        int size = 0;
+        int pending = 0;
+        counted.at(start) = true;
+        cells.at(pending++) = start;
+        while(pending > 0)
+        {
+            int cell = cells.at(--pending);
+            int x = cell % Board::COLUMNS;
+            int y = cell / Board::COLUMNS;
+            size += 1;
+
+            const int neighbours[4][2] = {{x - 1, y}, {x + 1, y}, {x, y - 1}, {x, y + 1}};
+            for(const auto& neighbour: neighbours)
+            {
+                int nx = neighbour[0];
+                int ny = neighbour[1];
+                if(nx < 0 || nx >= Board::COLUMNS || ny < top || ny >= Board::ROWS)
+                {
+                    continue;
+                }
+                int index = ny * Board::COLUMNS + nx;
+                if(not counted.at(index) && board.occupied(nx, ny) == 0)
+                {
+                    counted.at(index) = true;
+                    cells.at(pending++) = index;
+                }
+            }
+        }
+
+        if(size % Board::BLOCKS_PER_TETROMINO != 0)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+PuzzleSolver::Key PuzzleSolver::key_of(const Board& board, std::uint32_t piece) const
+{
+    Key key;
+    key.cells.fill(0);
+    key.piece = piece;
+    for(int y = 0; y < Board::ROWS; y++)
+    {
+        for(int x = 0; x < Board::COLUMNS; x++)
+        {
+            if(board.occupied(x, y) > 0)
+            {
+                int bit = y * Board::COLUMNS + x;
+                key.cells.at(bit / 64) |= std::uint64_t(1) << (bit % 64);
+            }
+        }
+    }
+    return key;
+}
+
+bool PuzzleSolver::remembered(const Key& key)
+{
+    std::size_t hash = KeyHash()(key);
+    Shard& shard = memo_.at((hash >> 32) % SHARDS);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    return shard.keys.count(key) > 0;
+}
+
+void PuzzleSolver::remember(const Key& key)
+{
+    //A full memo only makes the search slower, not wrong
+    if(memo_size_ >= settings_.memo_limit)
+    {
+        return;
+    }
+
+    std::size_t hash = KeyHash()(key);
+    Shard& shard = memo_.at((hash >> 32) % SHARDS);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    if(shard.keys.insert(key).second)
+    {
+        memo_size_ += 1;
+    }
+}
+
+void PuzzleSolver::flush(Worker& worker)
+{
+    nodes_ += worker.nodes;
+    pruned_ += worker.pruned;
+    duplicates_ += worker.duplicates;
+    memo_hits_ += worker.memo_hits;
+    raise_to(deepest_, worker.deepest);
+    worker.nodes = 0;
+    worker.pruned = 0;
+    worker.duplicates = 0;
+    worker.memo_hits = 0;
+}
@@ -0,0 +1,247 @@
+/* Tetris project: puzzlesolver.hh
+ *
+ * Header file for the puzzle solver, finds the placements that solve a
+ * puzzle or proves that there are none. While a tetromino falls, the
+ * player can move it sideways and flip it on every row, so the places
+ * where it can stop are found by trying every move from every place it
+ * can reach: left, right, flip and one tick of gravity. The moves are
+ * the ones of the board, so the rules are exactly the ones of the game,
+ * tucks and flips under overhangs included.
+ *
+ * The search is depth first. The placements of the first tetrominos are
+ * split into tasks that the threads take one at a time. Boards that were
+ * searched without finding a solution are remembered in a memo shared
+ * by all the threads and split into shards with their own locks. A
+ * branch is cut when it can't be solved anymore:
+ *  - something is above the rows to fill
+ *  - an empty area of the rows to fill has a number of cells that isn't
+ *    a multiple of four
+ *  - an empty area is closed from above, no tetromino can get into it
+ * Placements that give the same board (e.g. flipping an O) are only
+ * searched once, and the lowest placements are tried first.
+ *
+ * Program author/editor:
+ * Name: Rasmus Kivinen
+ * Student number: 285870
+ * UserID: kivinenr
+ * E-Mail: rasmus.kivinen@tuni.fi
+ * */
+
+#ifndef PUZZLESOLVER_HH
+#define PUZZLESOLVER_HH
+
+#include "puzzle.hh"
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+class PuzzleSolver
+{
+public:
+    enum Status {IDLE,
+                 RUNNING,
+                 SOLVED,
+                 NO_SOLUTION,
+                 CANCELLED};
+
+    struct Settings
+    {
+        int threads = 1;
+        // Boards the memo remembers at most, about 100 bytes each
+        std::size_t memo_limit = 1 << 20;
+    };
+
+    struct Progress
+    {
+        // Boards searched
+        std::uint64_t nodes = 0;
+        // Placements cut because the board couldn't be solved anymore
+        std::uint64_t pruned = 0;
+        // Placements that gave the same board as an earlier one
+        std::uint64_t duplicates = 0;
+        // Boards found in the memo, and the size of the memo
+        std::uint64_t memo_hits = 0;
+        std::uint64_t memo_size = 0;
+        // Tasks the search was split into and how many are finished
+        int tasks = 0;
+        int tasks_done = 0;
+        // Most tetrominos placed on any board so far, and how many the
+        // solution needs
+        int deepest = 0;
+        int pieces = 0;
+    };
+
+    PuzzleSolver();
+    ~PuzzleSolver();
+
+    /**
+     * @brief start Starts solving the puzzle on threads of its own
+     * @param puzzle to solve
+     * @param settings of the search
+     * @return false if the puzzle can't even be started, see error()
+     */
+    bool start(const Puzzle& puzzle, const Settings& settings);
+
+    /**
+     * @brief cancel Stops the search as soon as possible
+     */
+    void cancel();
+
+    /**
+     * @brief wait Waits until the search has ended
+     */
+    void wait();
+
+    Status status() const;
+    Progress progress() const;
+    const std::string& error() const;
+
+    /**
+     * @brief solution Where each tetromino of the solution stops, only
+     *        after the status is SOLVED
+     */
+    const std::vector<Board::Tetromino>& solution() const;
+
+private:
+    // A board is known by its filled cells and the next tetromino. Placed
+    // tetrominos never move again, because nothing is ever removed from
+    // below them.
+    struct Key
+    {
+        std::array<std::uint64_t, (Board::COLUMNS * Board::ROWS + 63) / 64> cells;
+        std::uint32_t piece;
+
+        bool operator==(const Key& other) const;
+    };
+
+    struct KeyHash
+    {
+        std::size_t operator()(const Key& key) const;
+    };
+
+    struct Shard
+    {
+        std::mutex mutex;
+        std::unordered_set<Key, KeyHash> keys;
+    };
+
+    struct Child
+    {
+        Board::Tetromino placement;
+        // Sum of the rows of the placed blocks, lower placements first
+        int depth;
+        Key key;
+    };
+
+    struct Task
+    {
+        Board board;
+        std::uint32_t piece;
+        std::vector<Board::Tetromino> path;
+    };
+
+    // A place of the falling tetromino, flipped tells which way it is
+    // turned so that its first block tells where it is
+    struct State
+    {
+        Board::Tetromino shape;
+        bool flipped;
+    };
+
+    // Boards and lists a thread reuses on every level of its search
+    struct Worker
+    {
+        std::vector<Board> boards;
+        std::vector<Board> spawned;
+        std::vector<std::vector<Child>> children;
+        std::vector<Board::Tetromino> path;
+        Board scratch;
+
+        // Places of the falling tetromino still to try and the ones that
+        // have been reached, by flip, row and column of the first block
+        std::vector<State> states;
+        std::vector<std::uint8_t> reached;
+
+        // Counted here and added to the shared progress now and then
+        std::uint64_t nodes = 0;
+        std::uint64_t pruned = 0;
+        std::uint64_t duplicates = 0;
+        std::uint64_t memo_hits = 0;
+        int deepest = 0;
+    };
+
+    static const int SHARDS = 64;
+
+    void run();
+    void work();
+
+    /**
+     * @brief search Searches the placements of the tetromino and the ones
+     *        after it, depth first
+     * @param worker with the board at boards[level]
+     * @param level in the worker's boards
+     * @param piece index of the next tetromino
+     * @return true if a solution was found, the placements are in the path
+     */
+    bool search(Worker& worker, std::size_t level, std::uint32_t piece);
+
+    /**
+     * @brief expand Lists the placements of the next tetromino that are
+     *        worth searching, lowest first. Every place the tetromino can
+     *        reach while falling is tried, and the ones where the gravity
+     *        stops it are the placements.
+     * @return false if the tetromino couldn't be created
+     */
+    bool expand(Worker& worker, const Board& board, std::uint32_t piece,
+                Board& spawned, std::vector<Child>& children);
+
+    /**
+     * @brief place Puts the tetromino where it stops and lets the gravity
+     *        tick, which is when the game creates the next one
+     * @param board with the tetromino created at the top
+     * @param placement where the tetromino stops
+     */
+    static void place(Board& board, const Board::Tetromino& placement);
+
+    bool can_be_solved(const Board& board) const;
+    Key key_of(const Board& board, std::uint32_t piece) const;
+    bool remembered(const Key& key);
+    void remember(const Key& key);
+    void flush(Worker& worker);
+
+    // The puzzle being solved
+    Board start_;
+    std::vector<std::uint8_t> pieces_;
+    int rows_ = 0;
+    Settings settings_;
+
+    std::thread thread_;
+    std::atomic<int> status_{IDLE};
+    std::atomic<bool> stop_{false};
+    std::atomic<bool> cancelled_{false};
+    std::string error_;
+
+    std::vector<Task> tasks_;
+    std::atomic<std::size_t> next_task_{0};
+
+    std::array<Shard, SHARDS> memo_;
+
+    std::atomic<std::uint64_t> nodes_{0};
+    std::atomic<std::uint64_t> pruned_{0};
+    std::atomic<std::uint64_t> duplicates_{0};
+    std::atomic<std::uint64_t> memo_hits_{0};
+    std::atomic<std::uint64_t> memo_size_{0};
+    std::atomic<int> tasks_count_{0};
+    std::atomic<int> tasks_done_{0};
+    std::atomic<int> deepest_{0};
+
+    std::mutex solution_mutex_;
+    bool found_ = false;
+    std::vector<Board::Tetromino> solution_;
+};
+
+#endif // PUZZLESOLVER_HH
@@ -0,0 +1,531 @@
+/* Tetris project: replay.cpp
+ *
+ * Replay file, writes and reads recorded games
+ *
+ * Program author/editor:
+ * Name: Rasmus Kivinen
+ * Student number: 285870
+ * UserID: kivinenr
+ * E-Mail: rasmus.kivinen@tuni.fi
+ * */
+
+#include "replay.hh"
+#include "memorytracker.hh"
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+const char HEADER_MAGIC[8] = {'T', 'T', 'R', 'P', 'L', 'A', 'Y', '1'};
+const char FOOTER_MAGIC[8] = {'T', 'T', 'R', 'I', 'N', 'D', 'E', 'X'};
+const std::uint32_t VERSION = 1;
+const std::size_t HEADER_SIZE = 32;
+const std::size_t FOOTER_SIZE = 32;
+const std::size_t INDEX_ENTRY_SIZE = 16;
+
+// Bytes of a tetromino in a keyframe: kind and x, y of each block
+const std::size_t TETROMINO_SIZE = 1 + 2 * Board::BLOCKS_PER_TETROMINO;
+
+// Codes are stored in the lowest 4 bits of an event
+const int CODE_BITS = 4;
+const std::uint64_t CODE_MASK = (1 << CODE_BITS) - 1;
+}
+
+bool Replay::apply(Board& board, Event event, int kind)
+{
+    switch(event)
+    {
+    case MOVE_LEFT:
+        return board.move_block(Board::LEFT);
+    case MOVE_RIGHT:
+        return board.move_block(Board::RIGHT);
+    case MOVE_DOWN:
+        return board.move_block(Board::DOWN);
+    case FLIP:
+        return board.flip_shape();
+    case DROP:
+        board.drop_current();
+        return true;
+    case GRAVITY:
+        return board.drop_all();
+    case SPAWN:
+        return board.create_tetromino(kind);
+    default:
+        return false;
+    }
+}
+
+ReplayWriter::ReplayWriter()
+{
+}
+
+ReplayWriter::~ReplayWriter()
+{
+    close();
+}
+
+bool ReplayWriter::open(const std::string& filename,
+                        std::uint32_t keyframe_interval, std::uint32_t frame_ms)
+{
+    //The buffers of replay files are counted as persistence wherever
+    //they are used from
+    MemoryScope scope(MemoryTracker::PERSISTENCE);
+    close();
+
+    file_.open(filename, std::ofstream::binary | std::ofstream::trunc);
+    if(not file_.is_open())
+    {
+        return false;
+    }
+
+    offset_ = 0;
+    keyframe_interval_ = keyframe_interval > 0 ? keyframe_interval : 1;
+    frame_ = 0;
+    last_event_frame_ = 0;
+    next_keyframe_ = 0;
+    index_.clear();
+
+    write_bytes(HEADER_MAGIC, sizeof(HEADER_MAGIC));
+    write_u32(VERSION);
+    write_u32(keyframe_interval_);
+    write_u32(frame_ms);
+    write_u32(Board::COLUMNS);
+    write_u32(Board::ROWS);
+    write_u32(0);
+
+    return bool(file_);
+}
+
+bool ReplayWriter::is_open() const
+{
+    return file_.is_open();
+}
+
+void ReplayWriter::advance(std::uint64_t frame, const Board& board)
+{
+    MemoryScope scope(MemoryTracker::PERSISTENCE);
+    if(not file_.is_open())
+    {
+        return;
+    }
+
+    //Nothing has happened since the last event, so every keyframe that
+    //is due before this frame has the same board
+    while(next_keyframe_ <= frame)
+    {
+        index_.push_back({next_keyframe_, offset_});
+
+        write_varint(((next_keyframe_ - last_event_frame_) << CODE_BITS)
+                     | Replay::KEYFRAME);
+        last_event_frame_ = next_keyframe_;
+
+        const std::vector<Board::Tetromino>& shapes = board.tetrominos();
+        write_u16(shapes.size());
+        for(const auto& shape: shapes)
+        {
+            char bytes[TETROMINO_SIZE];
+            bytes[0] = shape.kind;
+            for(int i = 0; i < Board::BLOCKS_PER_TETROMINO; i++)
+            {
+                bytes[1 + 2 * i] = shape.blocks.at(i).x;
+                bytes[2 + 2 * i] = shape.blocks.at(i).y;
+            }
+            write_bytes(bytes, TETROMINO_SIZE);
+        }
+
+        next_keyframe_ += keyframe_interval_;
+    }
+
+    frame_ = frame;
+}
+
+void ReplayWriter::record(Replay::Event event, int kind)
+{
+    MemoryScope scope(MemoryTracker::PERSISTENCE);
+    if(not file_.is_open())
+    {
+        return;
+    }
+
+    std::uint64_t code = event == Replay::SPAWN ? Replay::SPAWN + kind : event;
+    write_varint(((frame_ - last_event_frame_) << CODE_BITS) | code);
+    last_event_frame_ = frame_;
+}
+
+bool ReplayWriter::close()
+{
+    MemoryScope scope(MemoryTracker::PERSISTENCE);
+    if(not file_.is_open())
+    {
+        return false;
+    }
+
+    std::uint64_t index_offset = offset_;
+    for(const auto& entry: index_)
+    {
+        write_u64(entry.first);
+        write_u64(entry.second);
+    }
+
+    write_u64(index_offset);
+    write_u64(index_.size());
+    write_u64(frame_ + 1);
+    write_bytes(FOOTER_MAGIC, sizeof(FOOTER_MAGIC));
+
+    bool success = bool(file_);
+    file_.close();
+    return success;
+}
+
+void ReplayWriter::write_varint(std::uint64_t value)
+{
+    //7 bits in each byte, the highest bit tells that more bytes follow
+    char bytes[10];
+    std::size_t size = 0;
+    do
+    {
+        bytes[size] = value & 0x7f;
+        value >>= 7;
+        if(value != 0)
+        {
+            bytes[size] |= 0x80;
+        }
+        size++;
+    }
+    while(value != 0);
+
+    write_bytes(bytes, size);
+}
+
+void ReplayWriter::write_u16(std::uint16_t value)
+{
+    char bytes[2] = {char(value & 0xff), char(value >> 8)};
+    write_bytes(bytes, sizeof(bytes));
+}
+
+void ReplayWriter::write_u32(std::uint32_t value)
+{
+    char bytes[4];
+    for(int i = 0; i < 4; i++)
+    {
+        bytes[i] = (value >> (8 * i)) & 0xff;
+    }
+    write_bytes(bytes, sizeof(bytes));
+}
+
+void ReplayWriter::write_u64(std::uint64_t value)
+{
+    char bytes[8];
+    for(int i = 0; i < 8; i++)
+    {
+        bytes[i] = (value >> (8 * i)) & 0xff;
+    }
+    write_bytes(bytes, sizeof(bytes));
+}
+
+void ReplayWriter::write_bytes(const char* data, std::size_t size)
+{
+    file_.write(data, size);
+    offset_ += size;
+}
+
+ReplayReader::ReplayReader()
+{
+}
+
+ReplayReader::~ReplayReader()
+{
+    close();
+}
+
+bool ReplayReader::open(const std::string& filename)
+{
+    MemoryScope scope(MemoryTracker::PERSISTENCE);
+    close();
+
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if(fd < 0)
+    {
+        error_ = "Could not open " + filename;
+        return false;
+    }
+
+    struct stat info;
+    if(fstat(fd, &info) != 0 || std::size_t(info.st_size) < HEADER_SIZE + FOOTER_SIZE)
+    {
+        ::close(fd);
+        error_ = filename + " is not a replay";
+        return false;
+    }
+
+    //The file is only read, so the pages can be shared with the page cache
+    //and only the parts around the seeked frames are ever loaded
+    void* mapping = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if(mapping == MAP_FAILED)
+    {
+        error_ = "Could not map " + filename;
+        return false;
+    }
+    data_ = static_cast<const unsigned char*>(mapping);
+    size_ = info.st_size;
+
+    std::size_t footer = size_ - FOOTER_SIZE;
+    if(std::memcmp(data_, HEADER_MAGIC, sizeof(HEADER_MAGIC)) != 0 ||
+       std::memcmp(data_ + footer + 24, FOOTER_MAGIC, sizeof(FOOTER_MAGIC)) != 0)
+    {
+        close();
+        error_ = filename + " is not a finished replay";
+        return false;
+    }
+
+    if(read_u32(8) != VERSION || read_u32(20) != std::uint32_t(Board::COLUMNS) ||
+       read_u32(24) != std::uint32_t(Board::ROWS))
+    {
+        close();
+        error_ = filename + " was recorded with a different version";
+        return false;
+    }
+
+    keyframe_interval_ = read_u32(12);
+    frame_ms_ = read_u32(16);
+    index_offset_ = read_u64(footer);
+    keyframes_ = read_u64(footer + 8);
+    frames_ = read_u64(footer + 16);
+    records_end_ = index_offset_;
+
+    if(keyframe_interval_ == 0 || keyframes_ == 0 || frames_ == 0 ||
+       index_offset_ < HEADER_SIZE ||
+       index_offset_ + keyframes_ * INDEX_ENTRY_SIZE != footer)
+    {
+        close();
+        error_ = filename + " has a damaged index";
+        return false;
+    }
+
+    //Reading goes back and forth between the keyframes
+    madvise(mapping, size_, MADV_RANDOM);
+
+    error_.clear();
+    return true;
+}
+
+void ReplayReader::close()
+{
+    if(data_ != nullptr)
+    {
+        munmap(const_cast<unsigned char*>(data_), size_);
+    }
+
+    data_ = nullptr;
+    size_ = 0;
+    frames_ = 0;
+    keyframes_ = 0;
+}
+
+const std::string& ReplayReader::error() const
+{
+    return error_;
+}
+
+std::uint64_t ReplayReader::frames() const
+{
+    return frames_;
+}
+
+std::uint32_t ReplayReader::keyframe_interval() const
+{
+    return keyframe_interval_;
+}
+
+std::uint32_t ReplayReader::frame_ms() const
+{
+    return frame_ms_;
+}
+
+bool ReplayReader::seek(std::uint64_t frame, Board& board, Cursor& cursor) const
+{
+    if(data_ == nullptr)
+    {
+        return false;
+    }
+
+    if(frame >= frames_)
+    {
+        frame = frames_ - 1;
+    }
+
+    //Keyframes are written every keyframe_interval frames, so the one
+    //before the frame is found directly from the index
+    std::uint64_t keyframe = frame / keyframe_interval_;
+    if(keyframe >= keyframes_)
+    {
+        keyframe = keyframes_ - 1;
+    }
+
+    std::size_t entry = index_offset_ + keyframe * INDEX_ENTRY_SIZE;
+    std::uint64_t keyframe_frame = read_u64(entry);
+    std::size_t offset = read_u64(entry + 8);
+    if(keyframe_frame > frame || offset >= records_end_)
+    {
+        return false;
+    }
+
+    std::uint64_t value;
+    if(not read_varint(offset, value) || (value & CODE_MASK) != Replay::KEYFRAME ||
+       not read_keyframe(offset, &board))
+    {
+        return false;
+    }
+
+    cursor.frame = keyframe_frame;
+    cursor.event_frame = keyframe_frame;
+    cursor.offset = offset;
+
+    return advance(frame, board, cursor);
+}
+
+bool ReplayReader::advance(std::uint64_t frame, Board& board, Cursor& cursor) const
+{
+    if(data_ == nullptr || frame + 1 < cursor.frame)
+    {
+        return false;
+    }
+
+    while(cursor.offset < records_end_)
+    {
+        std::size_t offset = cursor.offset;
+        std::uint64_t value;
+        if(not read_varint(offset, value))
+        {
+            return false;
+        }
+
+        //Events of later frames are left for the next advance
+        std::uint64_t event_frame = cursor.event_frame + (value >> CODE_BITS);
+        if(event_frame > frame)
+        {
+            break;
+        }
+
+        int code = value & CODE_MASK;
+        if(code == Replay::KEYFRAME)
+        {
+            if(not read_keyframe(offset, nullptr))
+            {
+                return false;
+            }
+        }
+        else if(code >= Replay::SPAWN)
+        {
+            if(code - Replay::SPAWN >= Board::NUMBER_OF_TETROMINOS)
+            {
+                return false;
+            }
+            Replay::apply(board, Replay::SPAWN, code - Replay::SPAWN);
+        }
+        else
+        {
+            Replay::apply(board, Replay::Event(code));
+        }
+
+        cursor.event_frame = event_frame;
+        cursor.offset = offset;
+    }
+
+    cursor.frame = frame + 1;
+    return true;
+}
+
+bool ReplayReader::read_varint(std::size_t& offset, std::uint64_t& value) const
+{
+    value = 0;
+    for(int shift = 0; shift < 64; shift += 7)
+    {
+        if(offset >= records_end_)
+        {
+            return false;
+        }
+
+        unsigned char byte = data_[offset++];
+        value |= std::uint64_t(byte & 0x7f) << shift;
+        if((byte & 0x80) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::uint64_t ReplayReader::read_u64(std::size_t offset) const
+{
+    std::uint64_t value = 0;
+    for(int i = 0; i < 8; i++)
+    {
+        value |= std::uint64_t(data_[offset + i]) << (8 * i);
+    }
+    return value;
+}
+
+std::uint32_t ReplayReader::read_u32(std::size_t offset) const
+{
+    std::uint32_t value = 0;
+    for(int i = 0; i < 4; i++)
+    {
+        value |= std::uint32_t(data_[offset + i]) << (8 * i);
+    }
+    return value;
+}
+
+bool ReplayReader::read_keyframe(std::size_t& offset, Board* board) const
+{
+    if(offset + 2 > records_end_)
+    {
+        return false;
+    }
+
+    std::size_t count = data_[offset] | (data_[offset + 1] << 8);
+    offset += 2;
+    if(offset + count * TETROMINO_SIZE > records_end_)
+    {
+        return false;
+    }
+
+    //Keyframes passed while advancing are only skipped
+    if(board == nullptr)
+    {
+        offset += count * TETROMINO_SIZE;
+        return true;
+    }
+
+    std::vector<Board::Tetromino> shapes(count);
+    for(auto& shape: shapes)
+    {
+        shape.kind = data_[offset];
+        if(shape.kind >= Board::NUMBER_OF_TETROMINOS)
+        {
+            return false;
+        }
+
+        for(int i = 0; i < Board::BLOCKS_PER_TETROMINO; i++)
+        {
+            //Checked before narrowing, a damaged byte over 127 would
+            //become a negative coordinate
+            unsigned char x = data_[offset + 1 + 2 * i];
+            unsigned char y = data_[offset + 2 + 2 * i];
+            if(x >= Board::COLUMNS || y >= Board::ROWS)
+            {
+                return false;
+            }
+            shape.blocks.at(i).x = x;
+            shape.blocks.at(i).y = y;
+        }
+        offset += TETROMINO_SIZE;
+    }
+
+    board->load(shapes);
+    return true;
+}
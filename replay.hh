@@ -0,0 +1,190 @@
+/* Tetris project: replay.hh
+ *
+ * Header file for replays. A replay file stores the whole board every
+ * keyframe_interval frames and the events (moves, gravity ticks and new
+ * tetrominos) between them. A seek index at the end of the file tells
+ * where each keyframe is, so any frame can be reached by loading the
+ * keyframe before it and replaying at most keyframe_interval frames.
+ *
+ * File layout (all numbers little-endian):
+ *   header   "TTRPLAY1", u32 version, u32 keyframe_interval,
+ *            u32 frame_ms, u32 columns, u32 rows, u32 reserved
+ *   records  varint(frame_delta * 16 + code) for each event, where
+ *            code is an Event or SPAWN + kind. A keyframe record has
+ *            code KEYFRAME and is followed by u16 tetromino count and
+ *            for each tetromino u8 kind and u8 x, u8 y of its blocks.
+ *   index    u64 frame, u64 offset of the record for each keyframe
+ *   footer   u64 index offset, u64 keyframes, u64 frames, "TTRINDEX"
+ *
+ * Program author/editor:
+ * Name: Rasmus Kivinen
+ * Student number: 285870
+ * UserID: kivinenr
+ * E-Mail: rasmus.kivinen@tuni.fi
+ * */
+
+#ifndef REPLAY_HH
+#define REPLAY_HH
+
+#include "board.hh"
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace Replay
+{
+// Things that change the board, SPAWN is followed by the kind of the
+// tetromino (SPAWN + kind)
+enum Event {MOVE_LEFT,
+            MOVE_RIGHT,
+            MOVE_DOWN,
+            FLIP,
+            DROP,
+            GRAVITY,
+            SPAWN,
+            KEYFRAME = 15};
+
+/**
+ * @brief apply Does the event to the board the same way the game did
+ * @param board to change
+ * @param event that happened
+ * @param kind of the new tetromino for SPAWN
+ * @return what the board function returned, e.g. for GRAVITY whether the
+ *         active tetromino had stopped
+ */
+bool apply(Board& board, Event event, int kind = 0);
+}
+
+class ReplayWriter
+{
+public:
+    ReplayWriter();
+    ~ReplayWriter();
+
+    /**
+     * @brief open Starts a new replay file, the first frame is 0
+     * @param filename of the replay
+     * @param keyframe_interval frames between two keyframes
+     * @param frame_ms length of a frame in milliseconds
+     * @return false if the file couldn't be created
+     */
+    bool open(const std::string& filename, std::uint32_t keyframe_interval,
+              std::uint32_t frame_ms);
+
+    bool is_open() const;
+
+    /**
+     * @brief advance Moves to the given frame, writing the keyframes that
+     *        are due before it. Must be called before the events of the frame.
+     * @param frame the current frame
+     * @param board as it is at the start of the frame
+     */
+    void advance(std::uint64_t frame, const Board& board);
+
+    /**
+     * @brief record Writes an event that happened on the current frame
+     * @param event that happened
+     * @param kind of the new tetromino for SPAWN
+     */
+    void record(Replay::Event event, int kind = 0);
+
+    /**
+     * @brief close Writes the seek index and the footer
+     * @return false if writing the file failed
+     */
+    bool close();
+
+private:
+    void write_varint(std::uint64_t value);
+    void write_u16(std::uint16_t value);
+    void write_u32(std::uint32_t value);
+    void write_u64(std::uint64_t value);
+    void write_bytes(const char* data, std::size_t size);
+
+    std::ofstream file_;
+    std::uint64_t offset_ = 0;
+    std::uint32_t keyframe_interval_ = 0;
+    std::uint64_t frame_ = 0;
+    std::uint64_t last_event_frame_ = 0;
+    std::uint64_t next_keyframe_ = 0;
+
+    // Frame and file offset of each keyframe written so far
+    std::vector<std::pair<std::uint64_t, std::uint64_t>> index_;
+};
+
+class ReplayReader
+{
+public:
+    // Position in the records, used to continue playing from a seek
+    struct Cursor
+    {
+        std::uint64_t frame = 0;
+        std::uint64_t event_frame = 0;
+        std::size_t offset = 0;
+    };
+
+    ReplayReader();
+    ~ReplayReader();
+
+    /**
+     * @brief open Maps the replay file to memory and reads its index
+     * @param filename of the replay
+     * @return false if the file couldn't be read, see error()
+     */
+    bool open(const std::string& filename);
+
+    void close();
+
+    const std::string& error() const;
+
+    // Number of frames in the replay, the last frame is frames() - 1
+    std::uint64_t frames() const;
+    std::uint32_t keyframe_interval() const;
+    std::uint32_t frame_ms() const;
+
+    /**
+     * @brief seek Sets the board as it was at the end of the frame,
+     *        starting from the keyframe before it
+     * @param frame to seek to
+     * @param board to set
+     * @param cursor is set to the frame for continuing with advance
+     * @return false if the replay is damaged
+     */
+    bool seek(std::uint64_t frame, Board& board, Cursor& cursor) const;
+
+    /**
+     * @brief advance Plays the events after the cursor up to the end of
+     *        the frame, which must not be before the frame of the cursor
+     * @param frame to play to
+     * @param board that is at the frame of the cursor
+     * @param cursor from seek or an earlier advance
+     * @return false if the replay is damaged
+     */
+    bool advance(std::uint64_t frame, Board& board, Cursor& cursor) const;
+
+private:
+    bool read_varint(std::size_t& offset, std::uint64_t& value) const;
+    std::uint64_t read_u64(std::size_t offset) const;
+    std::uint32_t read_u32(std::size_t offset) const;
+
+    /**
+     * @brief read_keyframe Loads the board from the keyframe record
+     *        that starts at the offset, or skips the record if board is null
+     * @return false if the record is damaged
+     */
+    bool read_keyframe(std::size_t& offset, Board* board) const;
+
+    const unsigned char* data_ = nullptr;
+    std::size_t size_ = 0;
+    std::string error_;
+
+    std::uint32_t keyframe_interval_ = 0;
+    std::uint32_t frame_ms_ = 0;
+    std::uint64_t frames_ = 0;
+    std::uint64_t keyframes_ = 0;
+    std::size_t index_offset_ = 0;
+    std::size_t records_end_ = 0;
+};
+
+#endif // REPLAY_HH
@@ -0,0 +1,462 @@
+/* Tetris project: rollbacksession.cpp
+ *
+ * Rollback session file, a versus game against another program
+ *
+ * Program author/editor:
+ * Name: Rasmus Kivinen
+ * Student number: 285870
+ * UserID: kivinenr
+ * E-Mail: rasmus.kivinen@tuni.fi
+ * */
+
+#include "rollbacksession.hh"
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+const std::int64_t TICK_NS = VersusGame::TICK_MS * 1000000LL;
+
+// Hellos are repeated until the peer answers
+const std::int64_t HELLO_INTERVAL_NS = 50 * 1000000LL;
+
+// Ticks between adjustments of the clock, and the most it is delayed at once
+const std::uint32_t SYNC_INTERVAL = 25;
+const int MAX_SYNC_TICKS = 4;
+
+const char MAGIC[] = "TTV1";
+const std::size_t MAGIC_SIZE = 4;
+
+const std::size_t MAX_BUTTONS_PER_DATAGRAM = 255;
+
+void put(std::vector<std::uint8_t>& data, std::uint64_t value, int bytes)
+{
+    for(int i = 0; i < bytes; i++)
+    {
+        data.push_back((value >> (8 * i)) & 0xff);
+    }
+}
+
+// Reads numbers from a received datagram, a datagram that ends too
+// early makes ok false
+struct Reader
+{
+    const std::vector<std::uint8_t>& data;
+    std::size_t position;
+    bool ok;
+
+    std::uint64_t get(int bytes)
+    {
+        if(position + bytes > data.size())
+        {
+            ok = false;
+            return 0;
+        }
+        std::uint64_t value = 0;
+        for(int i = 0; i < bytes; i++)
+        {
+            value |= std::uint64_t(data.at(position + i)) << (8 * i);
+        }
+        position += bytes;
+        return value;
+    }
+};
+
+void start_datagram(std::vector<std::uint8_t>& data, char type)
+{
+    data.assign(MAGIC, MAGIC + MAGIC_SIZE);
+    data.push_back(type);
+}
+}
+
+RollbackSession::RollbackSession():
+    saved_(RING), local_buttons_(RING), remote_buttons_(RING), used_buttons_(RING)
+{
+}
+
+bool RollbackSession::open(const Settings& settings, std::int64_t now_ns)
+{
+    settings_ = settings;
+    status_ = CONNECTING;
+    got_hello_ = false;
+    peer_got_hello_ = false;
+    next_hello_ns_ = now_ns;
+    stats_ = Stats();
+    return link_.open(settings.link);
+}
+
+void RollbackSession::close()
+{
+    link_.close();
+}
+
+const std::string& RollbackSession::error() const
+{
+    return link_.error();
+}
+
+bool RollbackSession::update(std::uint8_t buttons, std::int64_t now_ns)
+{
+    link_.flush(now_ns);
+    receive();
+
+    if(status_ == CONNECTING)
+    {
+        if(not got_hello_ || not peer_got_hello_)
+        {
+            send_hello(now_ns);
+            return false;
+        }
+        begin(now_ns);
+    }
+
+    //Wrong predictions are fixed before anything new is played, so the
+    //current tick is always played with the latest buttons
+    bool changed = false;
+    if(rollback_from_ < game_.tick())
+    {
+        rollback();
+        changed = true;
+    }
+    check_desync();
+
+    if(status_ != OVER)
+    {
+        std::int64_t due = std::max<std::int64_t>(now_ns - start_ns_, 0) / TICK_NS;
+        bool stalled = false;
+        while(game_.tick() < due)
+        {
+            //Too far ahead of the peer to roll back, or the peer hasn't
+            //acknowledged the buttons that would be overwritten
+            std::int64_t tick = game_.tick();
+            if(tick - remote_ticks_ >= MAX_ROLLBACK || tick - peer_ticks_ >= RING - 1)
+            {
+                stalled = true;
+                break;
+            }
+            local_buttons_.at(tick % RING) = buttons;
+            changed = simulate() || changed;
+        }
+
+        if(stalled)
+        {
+            //The clock waits with the game, so it continues at normal speed
+            //instead of playing the missed ticks at once
+            if(status_ != STALLED)
+            {
+                stats_.stalls += 1;
+            }
+            status_ = STALLED;
+            start_ns_ = now_ns - std::int64_t(game_.tick()) * TICK_NS;
+        }
+        else
+        {
+            status_ = PLAYING;
+        }
+
+        //The program that is further ahead of the other one waits a few
+        //ticks, half of the difference like both were meeting halfway
+        if(game_.tick() >= next_sync_tick_)
+        {
+            int advantage = int(game_.tick() - peer_tick_);
+            int wait = std::min((advantage - peer_advantage_) / 2, MAX_SYNC_TICKS);
+            if(wait > 0)
+            {
+                start_ns_ += wait * TICK_NS;
+            }
+            next_sync_tick_ = game_.tick() + SYNC_INTERVAL;
+        }
+
+        if(state_at(confirmed_tick()).is_over())
+        {
+            status_ = OVER;
+        }
+    }
+
+    send_input(now_ns);
+    return changed;
+}
+
+std::int64_t RollbackSession::next_update_ns() const
+{
+    if(status_ == CONNECTING)
+    {
+        return next_hello_ns_;
+    }
+    return start_ns_ + (std::int64_t(game_.tick()) + 1) * TICK_NS;
+}
+
+RollbackSession::Status RollbackSession::status() const
+{
+    return status_;
+}
+
+bool RollbackSession::done() const
+{
+    return status_ == OVER && peer_ticks_ >= game_.tick();
+}
+
+int RollbackSession::local_player() const
+{
+    return settings_.link.local_port < settings_.link.peer_port ? 0 : 1;
+}
+
+const VersusGame& RollbackSession::game() const
+{
+    return game_;
+}
+
+std::uint64_t RollbackSession::confirmed_checksum() const
+{
+    return state_at(confirmed_tick()).checksum();
+}
+
+std::uint32_t RollbackSession::confirmed_tick() const
+{
+    return std::min(remote_ticks_, game_.tick());
+}
+
+const RollbackSession::Stats& RollbackSession::stats() const
+{
+    return stats_;
+}
+
+void RollbackSession::receive()
+{
+    while(link_.receive(datagram_))
+    {
+        stats_.datagrams_received += 1;
+        if(datagram_.size() <= MAGIC_SIZE ||
+                std::memcmp(datagram_.data(), MAGIC, MAGIC_SIZE) != 0)
+        {
+            continue;
+        }
+
+        if(datagram_.at(MAGIC_SIZE) == 'H')
+        {
+            receive_hello(datagram_);
+        }
+        else if(datagram_.at(MAGIC_SIZE) == 'I')
+        {
+            receive_input(datagram_);
+        }
+    }
+}
+
+void RollbackSession::receive_hello(const std::vector<std::uint8_t>& data)
+{
+    Reader reader = {data, MAGIC_SIZE + 1, true};
+    bool got = reader.get(1);
+    Settings peer;
+    peer.seed_part = reader.get(8);
+    peer.gravity_interval_ms = std::int32_t(reader.get(4));
+    peer.das_ms = std::int32_t(reader.get(4));
+    peer.arr_ms = std::int32_t(reader.get(4));
+    peer.piece_mode = reader.get(1) == PieceGenerator::BAG ?
+                PieceGenerator::BAG : PieceGenerator::UNIFORM;
+    if(not reader.ok || status_ != CONNECTING)
+    {
+        return;
+    }
+
+    got_hello_ = true;
+    peer_got_hello_ = peer_got_hello_ || got;
+    peer_settings_ = peer;
+}
+
+void RollbackSession::receive_input(const std::vector<std::uint8_t>& data)
+{
+    //An input means the peer has started, so it has got the hello
+    if(status_ == CONNECTING)
+    {
+        peer_got_hello_ = true;
+        return;
+    }
+
+    Reader reader = {data, MAGIC_SIZE + 1, true};
+    std::uint32_t first = reader.get(4);
+    std::size_t count = reader.get(1);
+    std::size_t buttons_at = reader.position;
+    reader.position += count;
+    std::uint32_t ack = reader.get(4);
+    std::uint32_t peer_tick = reader.get(4);
+    int peer_advantage = std::int32_t(reader.get(4));
+    std::uint32_t checksum_tick = reader.get(4);
+    std::uint64_t checksum = reader.get(8);
+    if(not reader.ok)
+    {
+        return;
+    }
+
+    //The buttons are taken in order, those received earlier are skipped.
+    //Buttons too far ahead of the local game would overwrite ones that
+    //are still needed, the peer sends them again later.
+    for(std::size_t i = 0; i < count; i++)
+    {
+        std::uint32_t tick = first + i;
+        if(tick < remote_ticks_)
+        {
+            continue;
+        }
+        if(tick > remote_ticks_ || tick >= game_.tick() + RING - MAX_ROLLBACK)
+        {
+            break;
+        }
+
+        std::uint8_t buttons = data.at(buttons_at + i);
+        remote_buttons_.at(tick % RING) = buttons;
+        if(tick < game_.tick() && used_buttons_.at(tick % RING) != buttons)
+        {
+            rollback_from_ = std::min(rollback_from_, tick);
+        }
+        remote_ticks_ += 1;
+    }
+
+    peer_ticks_ = std::max(peer_ticks_, std::min(ack, game_.tick()));
+    peer_tick_ = peer_tick;
+    peer_advantage_ = peer_advantage;
+    if(checksum_tick != peer_checksum_tick_)
+    {
+        peer_checksum_tick_ = checksum_tick;
+        peer_checksum_ = checksum;
+        peer_checksum_checked_ = false;
+    }
+}
+
+void RollbackSession::send_hello(std::int64_t now_ns)
+{
+    if(now_ns < next_hello_ns_)
+    {
+        return;
+    }
+    next_hello_ns_ = now_ns + HELLO_INTERVAL_NS;
+
+    start_datagram(datagram_, 'H');
+    put(datagram_, got_hello_, 1);
+    put(datagram_, settings_.seed_part, 8);
+    put(datagram_, std::uint32_t(settings_.gravity_interval_ms), 4);
+    put(datagram_, std::uint32_t(settings_.das_ms), 4);
+    put(datagram_, std::uint32_t(settings_.arr_ms), 4);
+    put(datagram_, settings_.piece_mode, 1);
+    link_.send(datagram_, now_ns);
+    stats_.datagrams_sent += 1;
+}
+
+void RollbackSession::send_input(std::int64_t now_ns)
+{
+    //Every datagram has all the buttons the peer hasn't acknowledged
+    std::uint32_t first = peer_ticks_;
+    std::size_t count = std::min<std::size_t>(game_.tick() - first,
+                                              MAX_BUTTONS_PER_DATAGRAM);
+
+    start_datagram(datagram_, 'I');
+    put(datagram_, first, 4);
+    put(datagram_, count, 1);
+    for(std::size_t i = 0; i < count; i++)
+    {
+        datagram_.push_back(local_buttons_.at((first + i) % RING));
+    }
+    put(datagram_, remote_ticks_, 4);
+    put(datagram_, game_.tick(), 4);
+    put(datagram_, std::uint32_t(game_.tick() - peer_tick_), 4);
+    put(datagram_, confirmed_tick(), 4);
+    put(datagram_, confirmed_checksum(), 8);
+    link_.send(datagram_, now_ns);
+    stats_.datagrams_sent += 1;
+}
+
+void RollbackSession::begin(std::int64_t now_ns)
+{
+    //Player 0 decides the game, each player keeps their own repeat
+    int local = local_player();
+    const Settings& first = local == 0 ? settings_ : peer_settings_;
+
+    VersusGame::Settings game_settings;
+    game_settings.seed = settings_.seed_part ^ peer_settings_.seed_part;
+    game_settings.piece_mode = first.piece_mode;
+    game_settings.gravity_interval_ms = first.gravity_interval_ms;
+    game_settings.das_ms.at(local) = settings_.das_ms;
+    game_settings.arr_ms.at(local) = settings_.arr_ms;
+    game_settings.das_ms.at(1 - local) = peer_settings_.das_ms;
+    game_settings.arr_ms.at(1 - local) = peer_settings_.arr_ms;
+    game_.start(game_settings);
+
+    start_ns_ = now_ns;
+    remote_ticks_ = 0;
+    peer_ticks_ = 0;
+    rollback_from_ = 0;
+    peer_tick_ = 0;
+    peer_advantage_ = 0;
+    next_sync_tick_ = SYNC_INTERVAL;
+    peer_checksum_tick_ = 0;
+    peer_checksum_checked_ = true;
+    status_ = PLAYING;
+}
+
+bool RollbackSession::simulate()
+{
+    std::uint32_t tick = game_.tick();
+    saved_.at(tick % RING) = game_;
+
+    //The buttons of the peer that haven't arrived are predicted to be
+    //the ones it held on its latest received tick
+    std::uint8_t remote = 0;
+    if(tick < remote_ticks_)
+    {
+        remote = remote_buttons_.at(tick % RING);
+    }
+    else if(remote_ticks_ > 0)
+    {
+        remote = remote_buttons_.at((remote_ticks_ - 1) % RING);
+    }
+    used_buttons_.at(tick % RING) = remote;
+
+    std::array<std::uint8_t, VersusGame::PLAYERS> buttons;
+    buttons.at(local_player()) = local_buttons_.at(tick % RING);
+    buttons.at(1 - local_player()) = remote;
+    bool changed = game_.step(buttons);
+
+    if(rollback_from_ == tick)
+    {
+        rollback_from_ = game_.tick();
+    }
+    return changed;
+}
+
+void RollbackSession::rollback()
+{
+    std::uint32_t current = game_.tick();
+    int depth = current - rollback_from_;
+    stats_.rollbacks += 1;
+    stats_.resimulated_ticks += depth;
+    stats_.max_rollback = std::max(stats_.max_rollback, depth);
+
+    //Copying the saved state doesn't allocate, the boards keep their memory
+    game_ = saved_.at(rollback_from_ % RING);
+    while(game_.tick() < current)
+    {
+        simulate();
+    }
+    rollback_from_ = current;
+}
+
+void RollbackSession::check_desync()
+{
+    //The state of the tick must be confirmed here too and still saved
+    std::uint32_t tick = peer_checksum_tick_;
+    if(peer_checksum_checked_ || tick > confirmed_tick() || tick + RING <= game_.tick())
+    {
+        return;
+    }
+
+    peer_checksum_checked_ = true;
+    if(state_at(tick).checksum() != peer_checksum_)
+    {
+        stats_.desyncs += 1;
+    }
+}
+
+const VersusGame& RollbackSession::state_at(std::uint32_t tick) const
+{
+    return tick == game_.tick() ? game_ : saved_.at(tick % RING);
+}
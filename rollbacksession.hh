@@ -0,0 +1,213 @@
+/* Tetris project: rollbacksession.hh
+ *
+ * Header file for the rollback session, plays a versus game against
+ * another program by sending only the buttons of the local player over
+ * UDP. The buttons of the other player are predicted to stay the same
+ * as on the last tick that was received, so the game never waits for
+ * the network. When the real buttons arrive and differ from the
+ * prediction, the game is restored to the state it had before the first
+ * wrong tick and played again up to the current tick at once.
+ *
+ * Datagrams (all numbers little-endian), both start with "TTV1":
+ *   HELLO  u8 'H', u8 got the hello of the peer, u64 seed part,
+ *          i32 gravity interval, i32 das, i32 arr, u8 piece mode
+ *   INPUT  u8 'I', u32 first tick, u8 count, count button bytes,
+ *          u32 ticks received from the peer, u32 tick of the sender,
+ *          i32 advantage of the sender, u32 tick and u64 checksum of
+ *          the latest state whose buttons are all known
+ * Every INPUT repeats the buttons the peer hasn't acknowledged yet, so
+ * a lost datagram is replaced by the next one.
+ *
+ * Program author/editor:
+ * Name: Rasmus Kivinen
+ * Student number: 285870
+ * UserID: kivinenr
+ * E-Mail: rasmus.kivinen@tuni.fi
+ * */
+
+#ifndef ROLLBACKSESSION_HH
+#define ROLLBACKSESSION_HH
+
+#include "udplink.hh"
+#include "versusgame.hh"
+#include <cstdint>
+#include <vector>
+
+class RollbackSession
+{
+public:
+    // Ticks the game may run ahead of the buttons received from the peer
+    // before it stops to wait for them (256 ms)
+    static const int MAX_ROLLBACK = 64;
+
+    // Ticks of saved states and buttons kept, more than MAX_ROLLBACK and
+    // the buttons the peer hasn't acknowledged
+    static const int RING = 256;
+
+    enum Status {CONNECTING,
+                 PLAYING,
+                 STALLED,
+                 OVER};
+
+    struct Settings
+    {
+        UdpLink::Settings link;
+        // Settings of the game, the ones of player 0 are used for both
+        int gravity_interval_ms = 1000;
+        PieceGenerator::Mode piece_mode = PieceGenerator::UNIFORM;
+        // Repeat of the local player's moving buttons
+        int das_ms = 170;
+        int arr_ms = 50;
+        // Both players choose a random part of the seed
+        std::uint64_t seed_part = 0;
+    };
+
+    struct Stats
+    {
+        std::uint64_t rollbacks = 0;
+        // Ticks played again because of rollbacks
+        std::uint64_t resimulated_ticks = 0;
+        int max_rollback = 0;
+        // Times the game had to wait for the peer
+        std::uint64_t stalls = 0;
+        // Checksums from the peer that differed from the local ones
+        std::uint64_t desyncs = 0;
+        std::uint64_t datagrams_sent = 0;
+        std::uint64_t datagrams_received = 0;
+    };
+
+    RollbackSession();
+
+    /**
+     * @brief open Binds the local port and starts saying hello to the peer
+     * @param settings of the session
+     * @param now_ns current time
+     * @return false if the port couldn't be bound, see error()
+     */
+    bool open(const Settings& settings, std::int64_t now_ns);
+
+    void close();
+
+    const std::string& error() const;
+
+    /**
+     * @brief update Receives from the peer, rolls back if a prediction
+     *        was wrong, plays the ticks that are due with the local buttons
+     *        and sends them to the peer
+     * @param buttons held by the local player
+     * @param now_ns current time
+     * @return true if the game changed
+     */
+    bool update(std::uint8_t buttons, std::int64_t now_ns);
+
+    /**
+     * @brief next_update_ns When update should be called next, if nothing
+     *        is received before it
+     */
+    std::int64_t next_update_ns() const;
+
+    Status status() const;
+
+    /**
+     * @brief done The game is over and the peer has all the local buttons,
+     *        so the session can be closed
+     */
+    bool done() const;
+
+    // Index of the local player in the game, the one with the lower port is 0
+    int local_player() const;
+
+    /**
+     * @brief game The game at the current tick, with predicted buttons of
+     *        the peer for the ticks that haven't been received
+     */
+    const VersusGame& game() const;
+
+    /**
+     * @brief confirmed_checksum Checksum of the latest state whose buttons
+     *        are all known, the same on both computers unless they desync
+     */
+    std::uint64_t confirmed_checksum() const;
+    std::uint32_t confirmed_tick() const;
+
+    const Stats& stats() const;
+
+private:
+    void receive();
+    void receive_hello(const std::vector<std::uint8_t>& data);
+    void receive_input(const std::vector<std::uint8_t>& data);
+    void send_hello(std::int64_t now_ns);
+    void send_input(std::int64_t now_ns);
+
+    /**
+     * @brief begin Starts the game once both hellos have been received
+     */
+    void begin(std::int64_t now_ns);
+
+    /**
+     * @brief simulate Plays one tick from the current state and saves the
+     *        state before it
+     * @return true if a board changed
+     */
+    bool simulate();
+
+    /**
+     * @brief rollback Restores the state before the first wrongly predicted
+     *        tick and plays again up to the current tick
+     */
+    void rollback();
+
+    /**
+     * @brief check_desync Compares the latest checksum of the peer to the
+     *        local state of the same tick, once it is known locally too
+     */
+    void check_desync();
+
+    /**
+     * @brief state_at The state before the tick, for ticks that are still saved
+     */
+    const VersusGame& state_at(std::uint32_t tick) const;
+
+    Settings settings_;
+    UdpLink link_;
+    Status status_ = CONNECTING;
+
+    // Hello of the peer
+    bool got_hello_ = false;
+    bool peer_got_hello_ = false;
+    Settings peer_settings_;
+    std::int64_t next_hello_ns_ = 0;
+
+    VersusGame game_;
+    std::int64_t start_ns_ = 0;
+
+    // States before each tick and the buttons of each tick, by tick % RING
+    std::vector<VersusGame> saved_;
+    std::vector<std::uint8_t> local_buttons_;
+    std::vector<std::uint8_t> remote_buttons_;
+    // The buttons of the peer that were used, received or predicted
+    std::vector<std::uint8_t> used_buttons_;
+
+    // Ticks of the peer received so far, all of them are in remote_buttons_
+    std::uint32_t remote_ticks_ = 0;
+    // Ticks of the local player the peer has received
+    std::uint32_t peer_ticks_ = 0;
+    // First tick whose prediction turned out wrong, or the current tick
+    std::uint32_t rollback_from_ = 0;
+
+    // Latest tick and advantage reported by the peer, for keeping the
+    // clocks of the two programs together
+    std::uint32_t peer_tick_ = 0;
+    int peer_advantage_ = 0;
+    std::uint32_t next_sync_tick_ = 0;
+
+    // Checksum of a confirmed state from the peer, not yet compared
+    std::uint32_t peer_checksum_tick_ = 0;
+    std::uint64_t peer_checksum_ = 0;
+    bool peer_checksum_checked_ = true;
+
+    Stats stats_;
+    std::vector<std::uint8_t> datagram_;
+};
+
+#endif // ROLLBACKSESSION_HH
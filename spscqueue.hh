@@ -0,0 +1,82 @@
+/* Tetris project: spscqueue.hh
+ *
+ * Lock-free queue for passing values from one thread to another.
+ * Only one thread may push and only one thread may pop.
+ *
+ * Program author/editor:
+ * Name: Rasmus Kivinen
+ * Student number: 285870
+ * UserID: kivinenr
+ * E-Mail: rasmus.kivinen@tuni.fi
+ * */
+
+#ifndef SPSCQUEUE_HH
+#define SPSCQUEUE_HH
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+template <typename T, std::size_t Capacity>
+class SpscQueue
+{
+public:
+    /**
+     * @brief push Adds a value to the end of the queue, producer thread only
+     * @param value to add
+     * @return false if the queue was full
+     */
+    bool push(const T& value)
+    {
+        std::size_t tail = tail_.load(std::memory_order_relaxed);
+        std::size_t next = (tail + 1) % SLOTS;
+        if(next == head_.load(std::memory_order_acquire))
+        {
+            return false;
+        }
+
+        slots_[tail] = value;
+        tail_.store(next, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief pop Takes the first value of the queue, consumer thread only
+     * @param value is set to the first value
+     * @return false if the queue was empty
+     */
+    bool pop(T& value)
+    {
+        std::size_t head = head_.load(std::memory_order_relaxed);
+        if(head == tail_.load(std::memory_order_acquire))
+        {
+            return false;
+        }
+
+        value = slots_[head];
+        head_.store((head + 1) % SLOTS, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief empty Checks if there is nothing to pop, consumer thread only
+     */
+    bool empty() const
+    {
+        return head_.load(std::memory_order_relaxed) ==
+                tail_.load(std::memory_order_acquire);
+    }
+
+private:
+    // One slot is always left empty to tell a full queue from an empty one
+    static const std::size_t SLOTS = Capacity + 1;
+
+    std::array<T, SLOTS> slots_;
+
+    // The indexes are written by different threads, keeping them on
+    // separate cache lines stops the threads from slowing each other down
+    alignas(64) std::atomic<std::size_t> head_{0};
+    alignas(64) std::atomic<std::size_t> tail_{0};
+};
+
+#endif // SPSCQUEUE_HH
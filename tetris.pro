@@ -11,6 +11,8 @@ greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 TARGET = hanoi
 TEMPLATE = app
 
+CONFIG += c++14 thread
+
 # The following define makes your compiler emit warnings if you use
 # any feature of Qt which has been marked as deprecated (the exact warnings
 # depend on your compiler). Please consult the documentation of the
@@ -22,13 +24,49 @@ DEFINES += QT_DEPRECATED_WARNINGS
 # You can also select to disable deprecated APIs only up to a certain version of Qt.
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
+# Counts the memory of the game state, rendering and persistence and
+# shows it in a debug panel, see memorytracker.hh. Every allocation gets
+# a small header, so it is off by default.
+#DEFINES += TETRIS_MEMORY_TRACKING
+
 
 SOURCES += \
         main.cpp \
-        mainwindow.cpp
+        mainwindow.cpp \
+        board.cpp \
+        boardrenderer.cpp \
+        replay.cpp \
+        piecegenerator.cpp \
+        gamelog.cpp \
+        game.cpp \
+        gamethread.cpp \
+        memorytracker.cpp \
+        versusgame.cpp \
+        udplink.cpp \
+        rollbacksession.cpp \
+        versusthread.cpp \
+        puzzle.cpp \
+        puzzlesolver.cpp
 
 HEADERS += \
-        mainwindow.hh
+        mainwindow.hh \
+        board.hh \
+        boardrenderer.hh \
+        replay.hh \
+        piecegenerator.hh \
+        gamelog.hh \
+        game.hh \
+        gamerules.hh \
+        gamethread.hh \
+        memorytracker.hh \
+        versusgame.hh \
+        udplink.hh \
+        rollbacksession.hh \
+        versusthread.hh \
+        puzzle.hh \
+        puzzlesolver.hh \
+        spscqueue.hh \
+        triplebuffer.hh
 
 FORMS += \
         mainwindow.ui
@@ -0,0 +1,81 @@
+/* Tetris project: triplebuffer.hh
+ *
+ * Lock-free triple buffer for handing the latest value from one thread
+ * to another. The writer always has a buffer of its own to fill and the
+ * reader always has the latest published buffer, so neither of them
+ * ever waits for the other. Values the reader didn't have time to read
+ * are skipped.
+ *
+ * Program author/editor:
+ * Name: Rasmus Kivinen
+ * Student number: 285870
+ * UserID: kivinenr
+ * E-Mail: rasmus.kivinen@tuni.fi
+ * */
+
+#ifndef TRIPLEBUFFER_HH
+#define TRIPLEBUFFER_HH
+
+#include <array>
+#include <atomic>
+
+template <typename T>
+class TripleBuffer
+{
+public:
+    /**
+     * @brief write_buffer The buffer the writer fills next, writer thread only
+     * @return the buffer
+     */
+    T& write_buffer()
+    {
+        return buffers_[write_];
+    }
+
+    /**
+     * @brief publish Makes the filled write buffer the latest value,
+     *        writer thread only
+     */
+    void publish()
+    {
+        write_ = middle_.exchange(write_ | NEW_VALUE, std::memory_order_acq_rel)
+                 & INDEX_MASK;
+    }
+
+    /**
+     * @brief update Takes the latest published value, reader thread only
+     * @return true if a new value was published since the last update
+     */
+    bool update()
+    {
+        if((middle_.load(std::memory_order_relaxed) & NEW_VALUE) == 0)
+        {
+            return false;
+        }
+
+        read_ = middle_.exchange(read_, std::memory_order_acq_rel) & INDEX_MASK;
+        return true;
+    }
+
+    /**
+     * @brief read_buffer The value taken by the last update, reader thread only
+     * @return the value
+     */
+    const T& read_buffer() const
+    {
+        return buffers_[read_];
+    }
+
+private:
+    // The middle index has a flag telling that the writer has put a new
+    // value there which the reader hasn't taken yet
+    static const int NEW_VALUE = 4;
+    static const int INDEX_MASK = 3;
+
+    std::array<T, 3> buffers_;
+    int write_ = 0;
+    std::atomic<int> middle_{1};
+    int read_ = 2;
+};
+
+#endif // TRIPLEBUFFER_HH
@@ -0,0 +1,101 @@
+/* Tetris project: tuner/main.cpp
+ *
+ * Main function of the tuner. Usage:
+ *   tetristuner [--population N] [--generations N] [--games N]
+ *               [--max-pieces N] [--threads N] [--seed N]
+ *               [--checkpoint FILE] [--pieces uniform|bag] [--log FILE]
+ *
+ * Program author/editor:
+ * Name: Rasmus Kivinen
+ * Student number: 285870
+ * UserID: kivinenr
+ * E-Mail: rasmus.kivinen@tuni.fi
+ * */
+
+#include "tuner.hh"
+#include <iostream>
+#include <string>
+#include <thread>
+
+int main(int argc, char *argv[])
+{
+    Tuner::Settings settings;
+    settings.threads = std::max(1u, std::thread::hardware_concurrency());
+
+    for(int i = 1; i < argc; i++)
+    {
+        std::string option = argv[i];
+        if(i + 1 >= argc)
+        {
+            std::cerr << "Missing value for " << option << std::endl;
+            return 1;
+        }
+        std::string value = argv[++i];
+
+        if(option == "--population")
+        {
+            settings.population = std::stoi(value);
+        }
+        else if(option == "--generations")
+        {
+            settings.generations = std::stoi(value);
+        }
+        else if(option == "--games")
+        {
+            settings.games = std::stoi(value);
+        }
+        else if(option == "--max-pieces")
+        {
+            settings.max_pieces = std::stoi(value);
+        }
+        else if(option == "--threads")
+        {
+            settings.threads = std::stoi(value);
+        }
+        else if(option == "--seed")
+        {
+            settings.seed = std::stoull(value);
+        }
+        else if(option == "--checkpoint")
+        {
+            settings.checkpoint = value;
+        }
+        else if(option == "--log")
+        {
+            settings.log = value;
+        }
+        else if(option == "--pieces")
+        {
+            if(value == "bag")
+            {
+                settings.piece_mode = PieceGenerator::BAG;
+            }
+            else if(value == "uniform")
+            {
+                settings.piece_mode = PieceGenerator::UNIFORM;
+            }
+            else
+            {
+                std::cerr << "Unknown piece mode " << value << std::endl;
+                return 1;
+            }
+        }
+        else
+        {
+            std::cerr << "Unknown option " << option << std::endl;
+            return 1;
+        }
+    }
+
+    if(settings.population < 2 || settings.games < 1 || settings.threads < 1)
+    {
+        std::cerr << "Population must be at least 2, games and threads at least 1"
+                  << std::endl;
+        return 1;
+    }
+
+    Tuner tuner(settings);
+    tuner.run();
+
+    return 0;
+}
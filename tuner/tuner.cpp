@@ -0,0 +1,307 @@
+/* Tetris project: tuner.cpp
+ *
+ * Tuner file, evolves the weights of the bot
+ *
+ * Program author/editor:
+ * Name: Rasmus Kivinen
+ * Student number: 285870
+ * UserID: kivinenr
+ * E-Mail: rasmus.kivinen@tuni.fi
+ * */
+
+#include "tuner.hh"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+namespace
+{
+const std::string CHECKPOINT_HEADER = "tetris-tuner-checkpoint 1";
+
+// Number of candidates taking part in one tournament
+const int TOURNAMENT_SIZE = 4;
+
+// Probability and size of a mutation of a single weight
+const double MUTATION_RATE = 0.2;
+const double MUTATION_SIZE = 0.2;
+}
+
+Tuner::Tuner(const Settings& settings):
+    settings_(settings),
+    random_eng_(settings.seed)
+{
+}
+
+void Tuner::run()
+{
+    if(not settings_.log.empty() && not log_.open(settings_.log))
+    {
+        std::cerr << "Could not open " << settings_.log << ", games are not logged"
+                  << std::endl;
+    }
+
+    if(load_checkpoint())
+    {
+        std::cout << "Continuing from generation " << generation_
+                  << " of " << settings_.checkpoint << std::endl;
+    }
+    else
+    {
+        population_.clear();
+        for(int i = 0; i < settings_.population; i++)
+        {
+            population_.push_back(random_candidate());
+        }
+    }
+
+    while(generation_ < settings_.generations)
+    {
+        evaluate_population();
+        std::sort(population_.begin(), population_.end(),
+                  [](const Candidate& a, const Candidate& b)
+                  { return a.fitness > b.fitness; });
+        print_generation();
+
+        //The checkpoint always holds the next generation, so a finished
+        //run can be continued with a larger number of generations
+        next_generation();
+        generation_ += 1;
+        save_checkpoint();
+    }
+
+    log_.close();
+}
+
+void Tuner::evaluate_population()
+{
+    //Every worker takes the next unevaluated candidate until none are left.
+    //A worker only needs one bot at a time, so the memory used doesn't
+    //grow with the population or the number of games.
+    std::atomic<std::size_t> next_candidate(0);
+
+    auto worker = [this, &next_candidate]()
+    {
+        std::size_t i;
+        while((i = next_candidate++) < population_.size())
+        {
+            Candidate& candidate = population_.at(i);
+            if(candidate.evaluated)
+            {
+                continue;
+            }
+
+            Bot bot(candidate.weights);
+            GameLog::Record record;
+            GameLog::Record* logged = log_.is_open() ? &record : nullptr;
+            long total = 0;
+            for(int game = 0; game < settings_.games; game++)
+            {
+                auto start = std::chrono::system_clock::now();
+                total += bot.play_game(game + 1, settings_.max_pieces,
+                                       settings_.piece_mode, logged);
+
+                if(logged != nullptr)
+                {
+                    auto end = std::chrono::system_clock::now();
+                    record.source = "bot";
+                    record.start_time_ms = std::chrono::duration_cast<
+                            std::chrono::milliseconds>(start.time_since_epoch()).count();
+                    record.duration_ms = std::chrono::duration_cast<
+                            std::chrono::milliseconds>(end - start).count();
+                    log_.append(record);
+                }
+            }
+            candidate.fitness = double(total) / settings_.games;
+            candidate.evaluated = true;
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for(int i = 1; i < settings_.threads; i++)
+    {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for(auto& thread: threads)
+    {
+        thread.join();
+    }
+}
+
+void Tuner::next_generation()
+{
+    //The population is sorted, the best ones move on as they are
+    std::size_t elites = std::max<std::size_t>(1, population_.size() / 8);
+    std::vector<Candidate> next(population_.begin(),
+                                population_.begin() + elites);
+
+    std::uniform_real_distribution<double> chance(0, 1);
+    std::normal_distribution<double> mutation(0, MUTATION_SIZE);
+
+    while(next.size() < population_.size())
+    {
+        const Candidate& first = tournament();
+        const Candidate& second = tournament();
+
+        //The child is an average of the parents weighted by their fitness
+        Candidate child;
+        double total = first.fitness + second.fitness;
+        double share = total > 0 ? first.fitness / total : 0.5;
+        for(int i = 0; i < Bot::NUMBER_OF_FEATURES; i++)
+        {
+            child.weights[i] = share * first.weights[i]
+                    + (1 - share) * second.weights[i];
+            if(chance(random_eng_) < MUTATION_RATE)
+            {
+                child.weights[i] += mutation(random_eng_);
+            }
+        }
+        normalize(child.weights);
+
+        next.push_back(child);
+    }
+
+    population_ = next;
+}
+
+const Tuner::Candidate& Tuner::tournament()
+{
+    std::uniform_int_distribution<std::size_t> pick(0, population_.size() - 1);
+
+    const Candidate* winner = &population_.at(pick(random_eng_));
+    for(int i = 1; i < TOURNAMENT_SIZE; i++)
+    {
+        const Candidate& other = population_.at(pick(random_eng_));
+        if(other.fitness > winner->fitness)
+        {
+            winner = &other;
+        }
+    }
+    return *winner;
+}
+
+Tuner::Candidate Tuner::random_candidate()
+{
+    std::uniform_real_distribution<double> weight(-1, 1);
+
+    Candidate candidate;
+    for(auto& w: candidate.weights)
+    {
+        w = weight(random_eng_);
+    }
+    normalize(candidate.weights);
+    return candidate;
+}
+
+void Tuner::normalize(Bot::Weights& weights)
+{
+    double length = 0;
+    for(auto w: weights)
+    {
+        length += w * w;
+    }
+    length = std::sqrt(length);
+
+    if(length > 0)
+    {
+        for(auto& w: weights)
+        {
+            w /= length;
+        }
+    }
+}
+
+bool Tuner::load_checkpoint()
+{
+    std::ifstream infile(settings_.checkpoint);
+    if(not infile.is_open())
+    {
+        return false;
+    }
+
+    std::string header;
+    std::getline(infile, header);
+    if(header != CHECKPOINT_HEADER)
+    {
+        std::cerr << settings_.checkpoint << " is not a tuner checkpoint"
+                  << std::endl;
+        return false;
+    }
+
+    int size = 0;
+    infile >> generation_ >> random_eng_ >> size;
+
+    std::vector<Candidate> population;
+    for(int i = 0; i < size && infile; i++)
+    {
+        Candidate candidate;
+        for(auto& w: candidate.weights)
+        {
+            infile >> w;
+        }
+        infile >> candidate.fitness >> candidate.evaluated;
+        population.push_back(candidate);
+    }
+
+    if(not infile || population.empty())
+    {
+        std::cerr << settings_.checkpoint << " is damaged" << std::endl;
+        generation_ = 0;
+        return false;
+    }
+
+    population_ = population;
+    return true;
+}
+
+void Tuner::save_checkpoint() const
+{
+    std::string temporary = settings_.checkpoint + ".tmp";
+    std::ofstream outfile(temporary);
+
+    outfile.precision(17);
+    outfile << CHECKPOINT_HEADER << std::endl;
+    outfile << generation_ << std::endl;
+    outfile << random_eng_ << std::endl;
+    outfile << population_.size() << std::endl;
+    for(const auto& candidate: population_)
+    {
+        for(auto w: candidate.weights)
+        {
+            outfile << w << " ";
+        }
+        outfile << candidate.fitness << " " << candidate.evaluated << std::endl;
+    }
+    outfile.close();
+
+    if(not outfile || std::rename(temporary.c_str(),
+                                  settings_.checkpoint.c_str()) != 0)
+    {
+        std::cerr << "Could not write " << settings_.checkpoint << std::endl;
+    }
+}
+
+void Tuner::print_generation() const
+{
+    double total = 0;
+    for(const auto& candidate: population_)
+    {
+        total += candidate.fitness;
+    }
+
+    const Candidate& best = population_.front();
+    std::cout << "Generation " << generation_
+              << ": best " << best.fitness
+              << ", average " << total / population_.size()
+              << ", weights";
+    for(auto w: best.weights)
+    {
+        std::cout << " " << w;
+    }
+    std::cout << std::endl;
+}
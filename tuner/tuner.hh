@@ -0,0 +1,97 @@
+/* Tetris project: tuner.hh
+ *
+ * Header file for the tuner, finds good weights for the bot with an
+ * evolutionary algorithm. Candidates are evaluated in parallel and the
+ * progress is saved to a checkpoint file after every generation.
+ *
+ * Program author/editor:
+ * Name: Rasmus Kivinen
+ * Student number: 285870
+ * UserID: kivinenr
+ * E-Mail: rasmus.kivinen@tuni.fi
+ * */
+
+#ifndef TUNER_HH
+#define TUNER_HH
+
+#include "bot.hh"
+#include "gamelog.hh"
+#include <random>
+#include <string>
+#include <vector>
+
+class Tuner
+{
+public:
+    struct Settings
+    {
+        int population = 64;
+        int generations = 100;
+        // Games played by every candidate, game i uses seed i + 1 so that
+        // all candidates play the same tetromino sequences
+        int games = 32;
+        int max_pieces = 1000;
+        PieceGenerator::Mode piece_mode = PieceGenerator::UNIFORM;
+        int threads = 1;
+        std::uint64_t seed = 1;
+        std::string checkpoint = "tuner_checkpoint.txt";
+        // Every game played is added to this game log, if it isn't empty
+        std::string log;
+    };
+
+    struct Candidate
+    {
+        Bot::Weights weights = {};
+        double fitness = 0;
+        bool evaluated = false;
+    };
+
+    explicit Tuner(const Settings& settings);
+
+    /**
+     * @brief run Runs the generations, continuing from the checkpoint file
+     *        if there is one
+     */
+    void run();
+
+private:
+    /**
+     * @brief evaluate_population Plays the games of every candidate that
+     *        hasn't been evaluated yet, using all the worker threads
+     */
+    void evaluate_population();
+
+    /**
+     * @brief next_generation Keeps the best candidates and replaces the
+     *        rest with mutated children of tournament winners
+     */
+    void next_generation();
+
+    const Candidate& tournament();
+
+    Candidate random_candidate();
+
+    /**
+     * @brief normalize Scales the weights to unit length, only the
+     *        direction of the weights affects the placements
+     */
+    static void normalize(Bot::Weights& weights);
+
+    bool load_checkpoint();
+
+    /**
+     * @brief save_checkpoint Writes the population to a temporary file and
+     *        renames it, so an interrupted save keeps the old checkpoint
+     */
+    void save_checkpoint() const;
+
+    void print_generation() const;
+
+    Settings settings_;
+    std::vector<Candidate> population_;
+    int generation_ = 0;
+    std::mt19937_64 random_eng_;
+    GameLogWriter log_;
+};
+
+#endif // TUNER_HH
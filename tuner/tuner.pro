@@ -0,0 +1,31 @@
+#-------------------------------------------------
+#
+# Evolutionary tuner for the weights of the bot,
+# uses the same board rules as the game
+#
+#-------------------------------------------------
+
+TARGET = tetristuner
+TEMPLATE = app
+
+CONFIG += console c++14 thread
+CONFIG -= app_bundle qt
+
+INCLUDEPATH += ..
+
+SOURCES += \
+        main.cpp \
+        tuner.cpp \
+        ../board.cpp \
+        ../bot.cpp \
+        ../gamelog.cpp \
+        ../piecegenerator.cpp \
+        ../memorytracker.cpp
+
+HEADERS += \
+        tuner.hh \
+        ../board.hh \
+        ../bot.hh \
+        ../gamelog.hh \
+        ../piecegenerator.hh \
+        ../memorytracker.hh
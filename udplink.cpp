@@ -0,0 +1,150 @@
+/* Tetris project: udplink.cpp
+ *
+ * UDP link file, datagrams between two programs on the same computer
+ *
+ * Program author/editor:
+ * Name: Rasmus Kivinen
+ * Student number: 285870
+ * UserID: kivinenr
+ * E-Mail: rasmus.kivinen@tuni.fi
+ * */
+
+#include "udplink.hh"
+#include <arpa/inet.h>
+#include <cstring>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace
+{
+const std::int64_t NS_PER_MS = 1000000;
+
+// Larger than any datagram the versus mode sends
+const std::size_t MAX_DATAGRAM = 1024;
+
+sockaddr_in loopback(std::uint16_t port)
+{
+    sockaddr_in address;
+    std::memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    return address;
+}
+}
+
+UdpLink::UdpLink()
+{
+}
+
+UdpLink::~UdpLink()
+{
+    close();
+}
+
+bool UdpLink::open(const Settings& settings)
+{
+    close();
+    settings_ = settings;
+    error_.clear();
+
+    //The lower port is the first player, so the ports must differ
+    if(settings.local_port == settings.peer_port)
+    {
+        error_ = "The own port and the opponent's port must be different";
+        return false;
+    }
+    loss_eng_.seed(settings.local_port);
+
+    socket_ = ::socket(AF_INET, SOCK_DGRAM, 0);
+    if(socket_ < 0)
+    {
+        error_ = "Could not create a UDP socket";
+        return false;
+    }
+
+    //Receiving never waits, the game thread polls the socket every tick
+    fcntl(socket_, F_SETFL, fcntl(socket_, F_GETFL, 0) | O_NONBLOCK);
+
+    sockaddr_in address = loopback(settings.local_port);
+    if(bind(socket_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0)
+    {
+        close();
+        error_ = "Could not bind port " + std::to_string(settings.local_port);
+        return false;
+    }
+    return true;
+}
+
+void UdpLink::close()
+{
+    if(socket_ >= 0)
+    {
+        ::close(socket_);
+    }
+    socket_ = -1;
+    delayed_.clear();
+}
+
+const std::string& UdpLink::error() const
+{
+    return error_;
+}
+
+void UdpLink::send(const std::vector<std::uint8_t>& data, std::int64_t now_ns)
+{
+    std::uniform_int_distribution<int> percent(0, 99);
+    if(percent(loss_eng_) < settings_.loss_percent)
+    {
+        return;
+    }
+
+    if(settings_.latency_ms <= 0)
+    {
+        send_now(data);
+        return;
+    }
+    delayed_.push_back({now_ns + settings_.latency_ms * NS_PER_MS, data});
+}
+
+void UdpLink::flush(std::int64_t now_ns)
+{
+    while(not delayed_.empty() && delayed_.front().send_at <= now_ns)
+    {
+        send_now(delayed_.front().data);
+        delayed_.pop_front();
+    }
+}
+
+bool UdpLink::receive(std::vector<std::uint8_t>& data)
+{
+    if(socket_ < 0)
+    {
+        return false;
+    }
+
+    data.resize(MAX_DATAGRAM);
+    ssize_t size = recv(socket_, data.data(), data.size(), 0);
+    if(size < 0)
+    {
+        data.clear();
+        return false;
+    }
+    data.resize(size);
+    return true;
+}
+
+void UdpLink::send_now(const std::vector<std::uint8_t>& data)
+{
+    if(socket_ < 0)
+    {
+        return;
+    }
+
+    //A lost datagram is fine, the next one repeats everything it had
+    sockaddr_in address = loopback(settings_.peer_port);
+    sendto(socket_, data.data(), data.size(), 0,
+           reinterpret_cast<sockaddr*>(&address), sizeof(address));
+}
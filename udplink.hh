@@ -0,0 +1,92 @@
+/* Tetris project: udplink.hh
+ *
+ * Header file for the UDP link, sends and receives datagrams between two
+ * programs on the same computer. For testing netcode it can hold back
+ * every sent datagram for a simulated latency and drop a given share of
+ * them, as if they went over a slow and lossy network.
+ *
+ * Program author/editor:
+ * Name: Rasmus Kivinen
+ * Student number: 285870
+ * UserID: kivinenr
+ * E-Mail: rasmus.kivinen@tuni.fi
+ * */
+
+#ifndef UDPLINK_HH
+#define UDPLINK_HH
+
+#include <cstdint>
+#include <deque>
+#include <random>
+#include <string>
+#include <vector>
+
+class UdpLink
+{
+public:
+    struct Settings
+    {
+        // Ports on 127.0.0.1 of this program and the other one
+        std::uint16_t local_port = 45000;
+        std::uint16_t peer_port = 45001;
+        // One-way latency added to every sent datagram, in milliseconds
+        int latency_ms = 0;
+        // Percentage of sent datagrams that are dropped
+        int loss_percent = 0;
+    };
+
+    UdpLink();
+    ~UdpLink();
+
+    /**
+     * @brief open Binds the local port
+     * @param settings of the link
+     * @return false if the port couldn't be bound or the ports are the
+     *         same, see error()
+     */
+    bool open(const Settings& settings);
+
+    void close();
+
+    const std::string& error() const;
+
+    /**
+     * @brief send Sends a datagram to the peer, or queues it until the
+     *        simulated latency has passed
+     * @param data of the datagram
+     * @param now_ns current time
+     */
+    void send(const std::vector<std::uint8_t>& data, std::int64_t now_ns);
+
+    /**
+     * @brief flush Sends the queued datagrams whose latency has passed
+     * @param now_ns current time
+     */
+    void flush(std::int64_t now_ns);
+
+    /**
+     * @brief receive Takes the next received datagram without waiting
+     * @param data is set to the datagram
+     * @return false if nothing has been received
+     */
+    bool receive(std::vector<std::uint8_t>& data);
+
+private:
+    struct Delayed
+    {
+        std::int64_t send_at;
+        std::vector<std::uint8_t> data;
+    };
+
+    void send_now(const std::vector<std::uint8_t>& data);
+
+    int socket_ = -1;
+    Settings settings_;
+    std::string error_;
+
+    // Datagrams waiting for their latency, in the order they were sent
+    std::deque<Delayed> delayed_;
+    std::mt19937 loss_eng_;
+};
+
+#endif // UDPLINK_HH
@@ -0,0 +1,145 @@
+/* Tetris project: versus/main.cpp
+ *
+ * Main function of the versus test. Plays a versus game between two
+ * rollback sessions in the same program over loopback UDP, both players
+ * pressing random buttons, and checks that both ended up with the same
+ * game. Usage:
+ *   tetrisversus [--latency MS] [--loss PERCENT] [--gravity-ms MS]
+ *                [--seconds S] [--port PORT]
+ *
+ * Program author/editor:
+ * Name: Rasmus Kivinen
+ * Student number: 285870
+ * UserID: kivinenr
+ * E-Mail: rasmus.kivinen@tuni.fi
+ * */
+
+#include "versusthread.hh"
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+
+namespace
+{
+const VersusGame::Button BUTTONS[] = {VersusGame::BUTTON_LEFT,
+                                      VersusGame::BUTTON_RIGHT,
+                                      VersusGame::BUTTON_DOWN,
+                                      VersusGame::BUTTON_FLIP,
+                                      VersusGame::BUTTON_DROP};
+
+void print_stats(const std::string& name, const VersusThread::Snapshot& snapshot)
+{
+    const RollbackSession::Stats& stats = snapshot.stats;
+    std::cout << name << ": tick " << snapshot.tick
+              << ", confirmed " << snapshot.confirmed_tick
+              << ", score " << snapshot.board.score()
+              << ", rollbacks " << stats.rollbacks
+              << " (" << stats.resimulated_ticks << " ticks, at most "
+              << stats.max_rollback << ")"
+              << ", stalls " << stats.stalls
+              << ", datagrams " << stats.datagrams_sent << "/"
+              << stats.datagrams_received
+              << ", desyncs " << stats.desyncs << std::endl;
+}
+}
+
+int main(int argc, char *argv[])
+{
+    RollbackSession::Settings settings;
+    settings.gravity_interval_ms = 300;
+    int seconds = 60;
+    int port = 45100;
+
+    for(int i = 1; i < argc; i++)
+    {
+        std::string option = argv[i];
+        if(i + 1 >= argc)
+        {
+            std::cerr << "Missing value for " << option << std::endl;
+            return 1;
+        }
+        int value = std::stoi(argv[++i]);
+
+        if(option == "--latency")
+        {
+            settings.link.latency_ms = value;
+        }
+        else if(option == "--loss")
+        {
+            settings.link.loss_percent = value;
+        }
+        else if(option == "--gravity-ms")
+        {
+            settings.gravity_interval_ms = value;
+        }
+        else if(option == "--seconds")
+        {
+            seconds = value;
+        }
+        else if(option == "--port")
+        {
+            port = value;
+        }
+        else
+        {
+            std::cerr << "Unknown option " << option << std::endl;
+            return 1;
+        }
+    }
+
+    std::random_device device;
+    VersusThread players[VersusGame::PLAYERS];
+    for(int i = 0; i < VersusGame::PLAYERS; i++)
+    {
+        RollbackSession::Settings player = settings;
+        player.link.local_port = port + i;
+        player.link.peer_port = port + 1 - i;
+        player.seed_part = (std::uint64_t(device()) << 32) | device();
+        if(not players[i].start(player))
+        {
+            std::cerr << players[i].error() << std::endl;
+            return 1;
+        }
+    }
+
+    //Each player changes a random button every few milliseconds, the
+    //different timing on the two sides makes the predictions miss
+    std::mt19937 eng(device());
+    std::uniform_int_distribution<int> button(0, 4);
+    std::uniform_int_distribution<int> pause_ms(1, 30);
+    auto end = std::chrono::steady_clock::now() + std::chrono::seconds(seconds);
+    while(std::chrono::steady_clock::now() < end &&
+          (players[0].is_running() || players[1].is_running()))
+    {
+        VersusThread& player = players[eng() % VersusGame::PLAYERS];
+        player.set_button(BUTTONS[button(eng)], eng() % 2);
+        std::this_thread::sleep_for(std::chrono::milliseconds(pause_ms(eng)));
+    }
+
+    bool finished = not players[0].is_running() && not players[1].is_running();
+    for(auto& player: players)
+    {
+        player.stop();
+        player.update_snapshot();
+    }
+
+    const VersusThread::Snapshot& first = players[0].snapshot();
+    const VersusThread::Snapshot& second = players[1].snapshot();
+    print_stats("Player 1", first);
+    print_stats("Player 2", second);
+
+    if(not finished)
+    {
+        std::cout << "The game didn't end in " << seconds << " seconds" << std::endl;
+        return first.stats.desyncs + second.stats.desyncs == 0 ? 0 : 1;
+    }
+
+    bool same = first.confirmed_checksum == second.confirmed_checksum &&
+            first.result == -second.result;
+    std::cout << (first.result == 0 ? "Draw" :
+                  first.result > 0 ? "Player 1 won" : "Player 2 won")
+              << ", checksums " << (same ? "match" : "differ") << std::endl;
+    return same && first.stats.desyncs + second.stats.desyncs == 0 ? 0 : 1;
+}
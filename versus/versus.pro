@@ -0,0 +1,36 @@
+#-------------------------------------------------
+#
+# Plays a versus game between two rollback
+# sessions over loopback UDP and checks that
+# they stay in sync
+#
+#-------------------------------------------------
+
+TARGET = tetrisversus
+TEMPLATE = app
+
+CONFIG += console c++14 thread
+CONFIG -= app_bundle qt
+
+INCLUDEPATH += ..
+
+SOURCES += \
+        main.cpp \
+        ../board.cpp \
+        ../piecegenerator.cpp \
+        ../versusgame.cpp \
+        ../udplink.cpp \
+        ../rollbacksession.cpp \
+        ../versusthread.cpp \
+        ../memorytracker.cpp
+
+HEADERS += \
+        ../board.hh \
+        ../piecegenerator.hh \
+        ../gamerules.hh \
+        ../versusgame.hh \
+        ../udplink.hh \
+        ../rollbacksession.hh \
+        ../versusthread.hh \
+        ../triplebuffer.hh \
+        ../memorytracker.hh
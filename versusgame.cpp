@@ -0,0 +1,219 @@
+/* Tetris project: versusgame.cpp
+ *
+ * Versus game file, two players advanced tick by tick
+ *
+ * Program author/editor:
+ * Name: Rasmus Kivinen
+ * Student number: 285870
+ * UserID: kivinenr
+ * E-Mail: rasmus.kivinen@tuni.fi
+ * */
+
+#include "versusgame.hh"
+#include <algorithm>
+
+namespace
+{
+// Buttons that move and repeat while held, in the order of repeat_ticks_left
+const VersusGame::Button REPEATING[] = {VersusGame::BUTTON_LEFT,
+                                        VersusGame::BUTTON_RIGHT,
+                                        VersusGame::BUTTON_DOWN};
+
+int ticks_for(int ms)
+{
+    return std::max(1, ms / VersusGame::TICK_MS);
+}
+
+void hash(std::uint64_t& value, std::uint64_t data)
+{
+    //FNV-1a, a byte at a time
+    for(int i = 0; i < 8; i++)
+    {
+        value ^= (data >> (8 * i)) & 0xff;
+        value *= 0x100000001b3ULL;
+    }
+}
+}
+
+VersusGame::VersusGame()
+{
+}
+
+void VersusGame::start(const Settings& settings)
+{
+    settings_ = settings;
+    tick_ = 0;
+
+    for(auto& player: players_)
+    {
+        player.board.clear();
+        player.pieces.reset(settings.seed, settings.piece_mode);
+        player.buttons = 0;
+        player.repeat_ticks_left.fill(0);
+        player.game_over = false;
+
+        //Like in the single player game, the first tetromino doesn't
+        //speed up the gravity
+        player.gravity_interval_ms = 0;
+        spawn(player);
+        player.gravity_interval_ms = settings.gravity_interval_ms;
+        restart_gravity(player);
+    }
+}
+
+bool VersusGame::step(const std::array<std::uint8_t, PLAYERS>& buttons)
+{
+    bool changed = false;
+    if(not is_over())
+    {
+        for(int i = 0; i < PLAYERS; i++)
+        {
+            changed = step_player(i, buttons.at(i)) || changed;
+        }
+    }
+    tick_ += 1;
+    return changed;
+}
+
+std::uint32_t VersusGame::tick() const
+{
+    return tick_;
+}
+
+const VersusGame::Player& VersusGame::player(int index) const
+{
+    return players_.at(index);
+}
+
+bool VersusGame::is_over() const
+{
+    return std::any_of(players_.begin(), players_.end(),
+                       [](const Player& player) { return player.game_over; });
+}
+
+int VersusGame::winner() const
+{
+    if(players_.at(0).game_over == players_.at(1).game_over)
+    {
+        return -1;
+    }
+    return players_.at(0).game_over ? 1 : 0;
+}
+
+std::uint64_t VersusGame::checksum() const
+{
+    //The tick isn't included, so two finished games stay equal while
+    //the ticks keep going
+    std::uint64_t value = 0xcbf29ce484222325ULL;
+    for(const auto& player: players_)
+    {
+        for(const auto& shape: player.board.tetrominos())
+        {
+            hash(value, shape.kind);
+            for(auto block: shape.blocks)
+            {
+                hash(value, (std::uint8_t(block.x) << 8) | std::uint8_t(block.y));
+            }
+        }
+        hash(value, player.pieces.index());
+        hash(value, player.gravity_interval_ms);
+        hash(value, player.gravity_ticks_left);
+        hash(value, player.buttons);
+        for(auto ticks: player.repeat_ticks_left)
+        {
+            hash(value, ticks);
+        }
+        hash(value, player.game_over);
+    }
+    return value;
+}
+
+bool VersusGame::step_player(int index, std::uint8_t buttons)
+{
+    Player& player = players_.at(index);
+    if(player.game_over)
+    {
+        return false;
+    }
+
+    std::uint8_t pressed = buttons & ~player.buttons;
+    player.buttons = buttons;
+
+    //Moves of this tick with delayed auto shift and auto repeat, the same
+    //way as the single player game does them with its clock
+    int moves[3] = {};
+    for(int i = 0; i < 3; i++)
+    {
+        if(pressed & REPEATING[i])
+        {
+            moves[i] = 1;
+            player.repeat_ticks_left.at(i) = ticks_for(settings_.das_ms.at(index));
+        }
+        else if(buttons & REPEATING[i])
+        {
+            player.repeat_ticks_left.at(i) -= 1;
+            if(player.repeat_ticks_left.at(i) <= 0)
+            {
+                moves[i] = 1;
+                player.repeat_ticks_left.at(i) = ticks_for(settings_.arr_ms.at(index));
+            }
+        }
+    }
+
+    //Left and right on the same tick cancel each other out
+    bool changed = false;
+    if(moves[0] != moves[1])
+    {
+        changed = player.board.move_block(moves[0] ? Board::LEFT : Board::RIGHT);
+    }
+    if(moves[2])
+    {
+        changed = player.board.move_block(Board::DOWN) || changed;
+    }
+    if(pressed & BUTTON_DOWN)
+    {
+        restart_gravity(player);
+    }
+    if(pressed & BUTTON_FLIP)
+    {
+        changed = player.board.flip_shape() || changed;
+    }
+    if(pressed & BUTTON_DROP)
+    {
+        player.board.drop_current();
+        changed = true;
+    }
+
+    player.gravity_ticks_left -= 1;
+    if(player.gravity_ticks_left <= 0)
+    {
+        restart_gravity(player);
+        if(player.board.drop_all())
+        {
+            spawn(player);
+        }
+        changed = true;
+    }
+    return changed;
+}
+
+void VersusGame::spawn(Player& player)
+{
+    if(player.board.spawn_blocked())
+    {
+        player.game_over = true;
+        return;
+    }
+
+    player.board.create_tetromino(player.pieces.next());
+
+    if(GameRules::speed_up(player.gravity_interval_ms))
+    {
+        restart_gravity(player);
+    }
+}
+
+void VersusGame::restart_gravity(Player& player)
+{
+    player.gravity_ticks_left = ticks_for(player.gravity_interval_ms);
+}
@@ -0,0 +1,113 @@
+/* Tetris project: versusgame.hh
+ *
+ * Header file for the versus game, two players on their own boards with
+ * the same tetromino sequence. The last one whose spawning area is still
+ * free wins. Unlike Game, the versus game has no clock: it advances one
+ * tick at a time with the buttons each player is holding, so the same
+ * buttons always give the same game on both computers. The whole state
+ * is a couple of boards and counters, so it can be copied every tick
+ * for rolling back.
+ *
+ * Program author/editor:
+ * Name: Rasmus Kivinen
+ * Student number: 285870
+ * UserID: kivinenr
+ * E-Mail: rasmus.kivinen@tuni.fi
+ * */
+
+#ifndef VERSUSGAME_HH
+#define VERSUSGAME_HH
+
+#include "board.hh"
+#include "gamerules.hh"
+#include "piecegenerator.hh"
+#include <array>
+#include <cstdint>
+
+class VersusGame
+{
+public:
+    static const int PLAYERS = 2;
+
+    // Length of a tick, the same as a frame of the single player game
+    static const int TICK_MS = GameRules::FRAME_MS;
+
+    // Bits of the buttons a player is holding on a tick
+    enum Button {BUTTON_LEFT = 1,
+                 BUTTON_RIGHT = 2,
+                 BUTTON_DOWN = 4,
+                 BUTTON_FLIP = 8,
+                 BUTTON_DROP = 16};
+
+    struct Settings
+    {
+        std::uint64_t seed = 0;
+        PieceGenerator::Mode piece_mode = PieceGenerator::UNIFORM;
+        int gravity_interval_ms = 1000;
+        // Delayed auto shift and auto repeat rate of each player
+        std::array<int, PLAYERS> das_ms = {{GameRules::DAS_MS, GameRules::DAS_MS}};
+        std::array<int, PLAYERS> arr_ms = {{GameRules::ARR_MS, GameRules::ARR_MS}};
+    };
+
+    struct Player
+    {
+        Board board;
+        PieceGenerator pieces;
+        int gravity_interval_ms = 0;
+        int gravity_ticks_left = 0;
+        // Buttons of the previous tick, a press is a button that wasn't held
+        std::uint8_t buttons = 0;
+        // Ticks until the next auto repeat of left, right and down
+        std::array<int, 3> repeat_ticks_left = {{0, 0, 0}};
+        bool game_over = false;
+    };
+
+    VersusGame();
+
+    /**
+     * @brief start Clears both boards and creates the first tetrominos
+     */
+    void start(const Settings& settings);
+
+    /**
+     * @brief step Advances the game by one tick
+     * @param buttons held by each player on this tick
+     * @return true if a board changed
+     */
+    bool step(const std::array<std::uint8_t, PLAYERS>& buttons);
+
+    std::uint32_t tick() const;
+    const Player& player(int index) const;
+
+    // The game is over when a player's spawning area is blocked
+    bool is_over() const;
+
+    /**
+     * @brief winner The player who is still playing when the game is over
+     * @return the index of the player, or -1 for a draw or if the game isn't over
+     */
+    int winner() const;
+
+    /**
+     * @brief checksum Hash of everything that affects the rest of the game,
+     *        two computers with the same checksum have the same game
+     */
+    std::uint64_t checksum() const;
+
+private:
+    bool step_player(int index, std::uint8_t buttons);
+
+    /**
+     * @brief spawn Creates the next tetromino of the player and speeds up
+     *        the gravity, or ends the game of the player
+     */
+    void spawn(Player& player);
+
+    void restart_gravity(Player& player);
+
+    Settings settings_;
+    std::array<Player, PLAYERS> players_;
+    std::uint32_t tick_ = 0;
+};
+
+#endif // VERSUSGAME_HH
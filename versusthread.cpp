@@ -0,0 +1,182 @@
+/* Tetris project: versusthread.cpp
+ *
+ * Versus thread file, runs a rollback session on its own thread
+ *
+ * Program author/editor:
+ * Name: Rasmus Kivinen
+ * Student number: 285870
+ * UserID: kivinenr
+ * E-Mail: rasmus.kivinen@tuni.fi
+ * */
+
+#include "versusthread.hh"
+#include "gamerules.hh"
+#include "memorytracker.hh"
+#include <chrono>
+
+namespace
+{
+// After the game is over the session keeps answering the peer for a
+// while, so the peer gets the last buttons even if some were lost
+const std::int64_t LINGER_NS = 1000 * 1000000LL;
+
+// How long the peer may go without acknowledging the end of the game
+const std::int64_t GIVE_UP_NS = 5000 * 1000000LL;
+}
+
+VersusThread::VersusThread()
+{
+}
+
+VersusThread::~VersusThread()
+{
+    stop();
+}
+
+bool VersusThread::start(const RollbackSession::Settings& settings)
+{
+    stop();
+    MemoryScope scope(MemoryTracker::GAME_STATE);
+
+    held_ = 0;
+    pressed_ = 0;
+    if(not session_.open(settings, GameRules::now_ns()))
+    {
+        return false;
+    }
+
+    publish();
+    running_ = true;
+    thread_ = std::thread(&VersusThread::run, this);
+    return true;
+}
+
+void VersusThread::stop()
+{
+    running_ = false;
+    wake();
+    if(thread_.joinable())
+    {
+        thread_.join();
+    }
+    session_.close();
+}
+
+const std::string& VersusThread::error() const
+{
+    return session_.error();
+}
+
+bool VersusThread::is_running() const
+{
+    return running_;
+}
+
+void VersusThread::set_publish_callback(const std::function<void()>& callback)
+{
+    //Only changed while the thread isn't running
+    stop();
+    publish_callback_ = callback;
+}
+
+void VersusThread::set_button(VersusGame::Button button, bool pressed)
+{
+    if(pressed)
+    {
+        held_ |= button;
+        pressed_ |= button;
+    }
+    else
+    {
+        held_ &= ~button;
+    }
+}
+
+bool VersusThread::update_snapshot()
+{
+    return snapshots_.update();
+}
+
+const VersusThread::Snapshot& VersusThread::snapshot() const
+{
+    return snapshots_.read_buffer();
+}
+
+void VersusThread::run()
+{
+    MemoryScope scope(MemoryTracker::GAME_STATE);
+    std::int64_t over_at = 0;
+    while(running_)
+    {
+        std::int64_t now = GameRules::now_ns();
+
+        //The buttons are sampled once per update, a quick tap counts
+        //as held for the ticks of this update
+        std::uint8_t buttons = held_ | pressed_.exchange(0);
+        RollbackSession::Status status = session_.status();
+        if(session_.update(buttons, now) || session_.status() != status)
+        {
+            publish();
+        }
+
+        if(session_.status() == RollbackSession::OVER)
+        {
+            if(over_at == 0)
+            {
+                over_at = now;
+            }
+            if((session_.done() && now - over_at >= LINGER_NS) ||
+                    now - over_at >= GIVE_UP_NS)
+            {
+                break;
+            }
+        }
+
+        sleep_until(session_.next_update_ns());
+    }
+
+    session_.close();
+    running_ = false;
+}
+
+void VersusThread::publish()
+{
+    const VersusGame& game = session_.game();
+    int local = session_.local_player();
+
+    Snapshot& snapshot = snapshots_.write_buffer();
+    snapshot.board = game.player(local).board;
+    snapshot.opponent_board = game.player(1 - local).board;
+    for(int i = 0; i < PieceGenerator::PREVIEW_SIZE; i++)
+    {
+        snapshot.preview.at(i) = game.player(local).pieces.preview(i);
+    }
+    snapshot.status = session_.status();
+    snapshot.result = game.winner() == -1 ? 0 : (game.winner() == local ? 1 : -1);
+    snapshot.tick = game.tick();
+    snapshot.confirmed_tick = session_.confirmed_tick();
+    snapshot.confirmed_checksum = session_.confirmed_checksum();
+    snapshot.stats = session_.stats();
+    snapshots_.publish();
+
+    if(publish_callback_)
+    {
+        publish_callback_();
+    }
+}
+
+void VersusThread::wake()
+{
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+    }
+    wake_.notify_one();
+}
+
+void VersusThread::sleep_until(std::int64_t time_ns)
+{
+    std::unique_lock<std::mutex> lock(wake_mutex_);
+    wake_.wait_until(lock, std::chrono::steady_clock::time_point(
+                         std::chrono::nanoseconds(time_ns)),
+                     [this]() { return not running_; });
+}
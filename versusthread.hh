@@ -0,0 +1,111 @@
+/* Tetris project: versusthread.hh
+ *
+ * Header file for the versus thread, runs a rollback session on its own
+ * thread like the game thread runs the single player game. The window
+ * sets the buttons the player is holding and reads the latest snapshot
+ * of both boards, neither of them ever waits for the network.
+ *
+ * Program author/editor:
+ * Name: Rasmus Kivinen
+ * Student number: 285870
+ * UserID: kivinenr
+ * E-Mail: rasmus.kivinen@tuni.fi
+ * */
+
+#ifndef VERSUSTHREAD_HH
+#define VERSUSTHREAD_HH
+
+#include "rollbacksession.hh"
+#include "triplebuffer.hh"
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+class VersusThread
+{
+public:
+    // Everything the window needs for drawing the versus game
+    struct Snapshot
+    {
+        Board board;
+        Board opponent_board;
+        std::array<std::uint8_t, PieceGenerator::PREVIEW_SIZE> preview = {};
+        RollbackSession::Status status = RollbackSession::CONNECTING;
+        // 1 if the local player won, -1 if they lost and 0 for a draw,
+        // once the status is OVER
+        int result = 0;
+        std::uint32_t tick = 0;
+        std::uint32_t confirmed_tick = 0;
+        std::uint64_t confirmed_checksum = 0;
+        RollbackSession::Stats stats;
+    };
+
+    VersusThread();
+    ~VersusThread();
+
+    /**
+     * @brief start Opens the session and starts connecting to the peer
+     * @param settings of the session
+     * @return false if the port couldn't be bound, see error()
+     */
+    bool start(const RollbackSession::Settings& settings);
+
+    /**
+     * @brief stop Stops the thread and closes the session, the last
+     *        snapshot can still be read
+     */
+    void stop();
+
+    const std::string& error() const;
+
+    bool is_running() const;
+
+    /**
+     * @brief set_publish_callback Sets a function that the thread calls
+     *        every time it has published a new snapshot
+     */
+    void set_publish_callback(const std::function<void()>& callback);
+
+    /**
+     * @brief set_button Marks a button of the local player held or
+     *        released. A press is never lost, even if the button is
+     *        released before the next tick.
+     * @param button that changed
+     * @param pressed true for a press, false for a release
+     */
+    void set_button(VersusGame::Button button, bool pressed);
+
+    /**
+     * @brief update_snapshot Takes the latest snapshot, only from the
+     *        thread that started the session
+     * @return true if it has changed since the last update
+     */
+    bool update_snapshot();
+
+    const Snapshot& snapshot() const;
+
+private:
+    void run();
+    void publish();
+    void wake();
+    void sleep_until(std::int64_t time_ns);
+
+    RollbackSession session_;
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+
+    // Buttons held now and buttons pressed since the last tick
+    std::atomic<std::uint8_t> held_{0};
+    std::atomic<std::uint8_t> pressed_{0};
+
+    std::mutex wake_mutex_;
+    std::condition_variable wake_;
+    std::function<void()> publish_callback_;
+
+    TripleBuffer<Snapshot> snapshots_;
+};
+
+#endif // VERSUSTHREAD_HH